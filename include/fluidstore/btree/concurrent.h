@@ -0,0 +1,192 @@
+#pragma once
+
+#include <fluidstore/btree/map.h>
+#include <fluidstore/btree/set.h>
+
+#include <array>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <vector>
+
+namespace btree
+{
+    namespace detail
+    {
+        // Keys are spread over Shards independent trees by hash, each guarded by its own reader-writer lock.
+        // Writers to different shards never contend and readers share a shard. Iterators can't outlive a lock,
+        // so elements are accessed through visitors that run while the shard is locked.
+        template < typename Container, typename Key, typename Value, typename Compare, typename Hash, std::size_t Shards > class concurrent_base
+        {
+        public:
+            using key_type = Key;
+            using value_type = typename Container::value_type;
+            using size_type = typename Container::size_type;
+
+            static_assert(Shards > 0);
+
+            bool contains(const key_type& key) const
+            {
+                auto& shard = get_shard(key);
+                std::shared_lock< std::shared_mutex > lock(shard.mutex);
+                return shard.container.find(key) != shard.container.end();
+            }
+
+            // Calls fn with the element under a shared lock, returns false if the key is missing.
+            template < typename Fn > bool visit(const key_type& key, Fn&& fn) const
+            {
+                auto& shard = get_shard(key);
+                std::shared_lock< std::shared_mutex > lock(shard.mutex);
+                auto it = shard.container.find(key);
+                if (it == shard.container.end())
+                {
+                    return false;
+                }
+
+                fn(*it);
+                return true;
+            }
+
+            size_type erase(const key_type& key)
+            {
+                auto& shard = get_shard(key);
+                std::unique_lock< std::shared_mutex > lock(shard.mutex);
+                return shard.container.erase(key);
+            }
+
+            size_type size() const
+            {
+                size_type size = 0;
+                for (auto& shard : shards_)
+                {
+                    std::shared_lock< std::shared_mutex > lock(shard.mutex);
+                    size += shard.container.size();
+                }
+
+                return size;
+            }
+
+            bool empty() const { return size() == 0; }
+
+            void clear()
+            {
+                for (auto& shard : shards_)
+                {
+                    std::unique_lock< std::shared_mutex > lock(shard.mutex);
+                    shard.container.clear();
+                }
+            }
+
+            // Calls fn for all elements in key order. All shards are locked shared for the duration of the call,
+            // so fn sees a consistent state.
+            template < typename Fn > void for_each(Fn&& fn) const
+            {
+                std::array< std::shared_lock< std::shared_mutex >, Shards > locks;
+                std::vector< std::pair< typename Container::const_iterator, typename Container::const_iterator > > ranges;
+                for (std::size_t i = 0; i < Shards; ++i)
+                {
+                    locks[i] = std::shared_lock< std::shared_mutex >(shards_[i].mutex);
+                    if (!shards_[i].container.empty())
+                    {
+                        ranges.emplace_back(shards_[i].container.begin(), shards_[i].container.end());
+                    }
+                }
+
+                // Shards are few, linear selection of the smallest head is enough.
+                while (!ranges.empty())
+                {
+                    std::size_t min = 0;
+                    for (std::size_t i = 1; i < ranges.size(); ++i)
+                    {
+                        if (Compare()(value_type_traits< Key, Value >::get_key(*ranges[i].first), value_type_traits< Key, Value >::get_key(*ranges[min].first)))
+                        {
+                            min = i;
+                        }
+                    }
+
+                    fn(*ranges[min].first);
+                    if (++ranges[min].first == ranges[min].second)
+                    {
+                        ranges.erase(ranges.begin() + min);
+                    }
+                }
+            }
+
+        protected:
+            struct shard
+            {
+                mutable std::shared_mutex mutex;
+                Container container;
+            };
+
+            shard& get_shard(const key_type& key) { return shards_[index(key)]; }
+            const shard& get_shard(const key_type& key) const { return shards_[index(key)]; }
+
+        private:
+            static std::size_t index(const key_type& key)
+            {
+                // std::hash of integers is usually identity, mix the bits so that strided keys spread evenly.
+                std::size_t h = Hash()(key);
+                h ^= h >> 33;
+                h *= 0xff51afd7ed558ccdull;
+                h ^= h >> 33;
+                return h % Shards;
+            }
+
+            std::array< shard, Shards > shards_;
+        };
+    }
+
+    template <
+        typename Key,
+        typename Compare = std::less< Key >,
+        typename Hash = std::hash< Key >,
+        std::size_t Shards = 16,
+        typename Container = set< Key, Compare >
+    > class concurrent_set
+        : public detail::concurrent_base< Container, Key, void, Compare, Hash, Shards >
+    {
+    public:
+        bool insert(const Key& key)
+        {
+            auto& shard = this->get_shard(key);
+            std::unique_lock< std::shared_mutex > lock(shard.mutex);
+            return shard.container.insert(key).second;
+        }
+    };
+
+    template <
+        typename Key,
+        typename Value,
+        typename Compare = std::less< Key >,
+        typename Hash = std::hash< Key >,
+        std::size_t Shards = 16,
+        typename Container = map< Key, Value, Compare >
+    > class concurrent_map
+        : public detail::concurrent_base< Container, Key, Value, Compare, Hash, Shards >
+    {
+    public:
+        bool insert(const std::pair< Key, Value >& value)
+        {
+            auto& shard = this->get_shard(value.first);
+            std::unique_lock< std::shared_mutex > lock(shard.mutex);
+            return shard.container.insert(value).second;
+        }
+
+        std::optional< Value > find(const Key& key) const
+        {
+            std::optional< Value > result;
+            this->visit(key, [&](const auto& value) { result.emplace(value.second); });
+            return result;
+        }
+
+        // Calls fn with a mutable reference to the value under an exclusive lock, inserting default value if needed.
+        template < typename Fn > void update(const Key& key, Fn&& fn)
+        {
+            auto& shard = this->get_shard(key);
+            std::unique_lock< std::shared_mutex > lock(shard.mutex);
+            fn(shard.container[key]);
+        }
+    };
+}
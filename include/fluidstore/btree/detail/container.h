@@ -13,15 +13,19 @@
 // 9. stateful/stateless comparator
 // 10. stateful/stateless allocator
 
+#include <array>
 #include <memory>
 #include <type_traits>
 #include <algorithm>
 #include <iterator>
 
 #include <fluidstore/btree/detail/fixed_vector.h>
+#include <fluidstore/btree/detail/key_search.h>
 
 #define BTREE_VALUE_NODE_LR
 #define BTREE_VALUE_NODE_APPEND
+#define BTREE_INTERNAL_NODE_APPEND
+#define BTREE_INTERNAL_NODE_COUNT
 //#define BTREE_INTERNAL_NODE_LR
 //#define BTREE_CHECK_TREE_INVARIANTS
 
@@ -139,6 +143,19 @@ namespace btree::detail
         static_assert((1ull << sizeof(SizeType) * 8) > 2 * value);
     };
 
+    template < typename Key, typename Value > struct node_payload { static constexpr std::size_t value = sizeof(Key) + sizeof(Value); };
+    template < typename Key > struct node_payload< Key, void > { static constexpr std::size_t value = sizeof(Key); };
+
+    // Dimension of nodes whose elements take roughly Bytes (256, 1024, 4096, ...). Size fields are widened to uint16_t
+    // when uint8_t can't hold 2 * N.
+    template < typename Key, typename Value, std::size_t Bytes > struct node_geometry
+    {
+        static constexpr const std::size_t value = std::max(std::size_t(8), Bytes / (2 * node_payload< Key, Value >::value));
+        static_assert(2 * value < (1ull << 16));
+
+        using size_type = std::conditional_t< (2 * value < (1ull << 8)), uint8_t, uint16_t >;
+    };
+
     template < typename Key, typename Value > struct value_type_traits
     {
         typedef std::pair< Key, Value > value_type;
@@ -374,6 +391,18 @@ namespace btree::detail
         ~container_base() = default;
     #endif  
 
+        // Replaces the content with a copy of other. The copy is built bottom-up with full nodes in a linear time,
+        // which makes it cheap enough to hand out immutable snapshots to readers.
+        template < typename AllocatorT > void assign(AllocatorT&& allocator, const container_type& other)
+        {
+            BTREE_ASSERT(this != &other);
+
+            clear(allocator);
+
+            auto it = other.begin();
+            bulk_load(allocator, other.size(), 1.0, [&](auto& ndata) { ndata.emplace_back(allocator, value_type(*it++)); });
+        }
+
         template < typename AllocatorT > void clear(AllocatorT&& allocator)
         {
             if (root_)
@@ -391,6 +420,153 @@ namespace btree::detail
         iterator lower_bound(const Compare& compare, const key_type& key) { return root_ ? lower_bound(compare, root_, key) : end(); }
         const_iterator lower_bound(const Compare& compare, const key_type& key) const { return root_ ? lower_bound(compare, root_, key) : end(); }
 
+        // Batched lookups, keys have to be sorted. Consecutive keys share the descent: the search stays in the current
+        // value node while keys fall inside it and otherwise climbs only up to the first node that covers the next key.
+        template < typename It, typename OutputIt > OutputIt find_many(const Compare& compare, It begin, It end, OutputIt out) const
+        {
+            if (!root_)
+            {
+                return std::fill_n(out, std::distance(begin, end), this->end());
+            }
+
+            search_many(compare, begin, end, [&](node_descriptor< value_node* > vn, node_size_type kindex, const key_type& key)
+            {
+                auto nkeys = vn.get_keys();
+                *out++ = kindex < nkeys.size() && key == nkeys[kindex] ? iterator(vn, kindex) : this->end();
+            });
+
+            return out;
+        }
+
+        template < typename It, typename OutputIt > OutputIt lower_bound_many(const Compare& compare, It begin, It end, OutputIt out) const
+        {
+            if (!root_)
+            {
+                return std::fill_n(out, std::distance(begin, end), this->end());
+            }
+
+            search_many(compare, begin, end, [&](node_descriptor< value_node* > vn, node_size_type kindex, const key_type&)
+            {
+                if (kindex < vn.get_keys().size())
+                {
+                    *out++ = iterator(vn, kindex);
+                }
+                else
+                {
+                #if defined(BTREE_VALUE_NODE_APPEND)
+                    auto right = get_right(vn);
+                    *out++ = right ? iterator(right, 0) : this->end();
+                #else
+                    *out++ = this->end();
+                #endif
+                }
+            });
+
+            return out;
+        }
+
+    #if defined(BTREE_INTERNAL_NODE_COUNT)
+        // Number of elements smaller than key.
+        size_type rank(const Compare& compare, const key_type& key) const
+        {
+            if (!root_)
+            {
+                return 0;
+            }
+
+            size_type result = 0;
+            node* n = root_;
+            size_type depth = depth_;
+            while (--depth)
+            {
+                auto in = desc(node_cast<internal_node*>(n));
+
+                auto nkeys = in.get_keys();
+                auto kindex = find_key_index(compare, nkeys, key);
+                node_size_type nindex = kindex;
+                if (kindex != nkeys.size() && key == nkeys[kindex])
+                {
+                    ++nindex;
+                }
+
+                auto children = in.template get_children< node* >();
+                for (node_size_type i = 0; i < nindex; ++i)
+                {
+                    result += get_count(children[i], depth == 1);
+                }
+
+                n = children[nindex];
+            }
+
+            auto vn = desc(node_cast<value_node*>(n));
+            return result + find_key_index(compare, vn.get_keys(), key);
+        }
+
+        // Iterator to the element at position index in sorted order, end() if out of range.
+        iterator nth(size_type index) const
+        {
+            if (index >= size_)
+            {
+                return end();
+            }
+
+            node* n = root_;
+            size_type depth = depth_;
+            while (--depth)
+            {
+                auto children = desc(node_cast<internal_node*>(n)).template get_children< node* >();
+                
+                node_size_type nindex = 0;
+                for (;; ++nindex)
+                {
+                    auto count = get_count(children[nindex], depth == 1);
+                    if (index < count)
+                    {
+                        break;
+                    }
+
+                    index -= count;
+                }
+
+                n = children[nindex];
+            }
+
+            return iterator(node_cast<value_node*>(n), static_cast< node_size_type >(index));
+        }
+
+        // Position of the iterator in sorted order, size() for end().
+        size_type index(const_iterator it) const
+        {
+            if (!it.node_)
+            {
+                return 0;
+            }
+
+            size_type result = it.kindex_;
+            bool valuenode = true;
+            node* n = it.node_;
+            for (auto p = it.node_->parent; p; p = p->parent)
+            {
+                auto children = desc(p).template get_children< node* >();
+                auto nindex = find_node_index(children, n);
+                for (node_size_type i = 0; i < nindex; ++i)
+                {
+                    result += get_count(children[i], valuenode);
+                }
+
+                valuenode = false;
+                n = p;
+            }
+
+            return result;
+        }
+
+        size_type distance(const_iterator first, const_iterator last) const
+        {
+            return index(last) - index(first);
+        }
+    #endif
+
         template < typename AllocatorT > std::pair< iterator, bool > insert(AllocatorT&& allocator, const Compare& compare, const value_type& value)
         {
             return emplace(allocator, compare, value);
@@ -403,12 +579,71 @@ namespace btree::detail
 
         template < typename AllocatorT, typename It > void insert(AllocatorT&& allocator, const Compare& compare, It begin, It end)
         {
+            if constexpr (std::is_base_of_v< std::forward_iterator_tag, typename std::iterator_traits< It >::iterator_category >)
+            {
+                // Sorted unique input can be merged in a linear time.
+                if (is_sorted_unique(compare, begin, end))
+                {
+                    insert_sorted(allocator, compare, begin, end);
+                    return;
+                }
+            }
+
             while (begin != end)
             {
                 insert(allocator, compare, *begin++);
             }
         }
 
+        // Set union with sorted and unique range, existing elements are kept. Fill factor is the desired occupancy of nodes, in the range [0.5, 1].
+        template < typename AllocatorT, typename It > void insert_sorted(AllocatorT&& allocator, const Compare& compare, It begin, It end, double fill_factor = 1.0)
+        {
+            BTREE_ASSERT(is_sorted_unique(compare, begin, end));
+
+            auto count = static_cast< size_type >(std::distance(begin, end));
+            if (empty())
+            {
+                bulk_load(allocator, count, fill_factor, [&](auto& ndata) { ndata.emplace_back(allocator, value_type(*begin++)); });
+            }
+            else if (count * 4 < size())
+            {
+                insert_sorted_inplace(allocator, compare, begin, end);
+            }
+            else
+            {
+                merge_sorted(allocator, compare, begin, end, fill_factor);
+            }
+        }
+
+        // Set union with sorted and unique range that is small compared to the container. Consecutive elements
+        // that fall into the same value node are inserted without descending from the root again.
+        template < typename AllocatorT, typename It > void insert_sorted_inplace(AllocatorT&& allocator, const Compare& compare, It begin, It end)
+        {
+            BTREE_ASSERT(is_sorted_unique(compare, begin, end));
+
+            while (begin != end)
+            {
+                if (!root_)
+                {
+                    emplace(allocator, compare, value_type(*begin++));
+                    continue;
+                }
+
+                auto [n, upper] = find_value_node_bound(compare, value_type_traits_type::get_key(*begin));
+                if (full(n))
+                {
+                    emplace(allocator, compare, value_type(*begin++));
+                    continue;
+                }
+
+                // Separators do not change until the node is split, so the bound stays valid.
+                do
+                {
+                    insert(allocator, compare, n, value_type(*begin++));
+                } while (begin != end && !full(n) && (!upper || compare(value_type_traits_type::get_key(*begin), *upper)));
+            }
+        }
+
         template < typename AllocatorT, typename It > void insert(AllocatorT&& allocator, const Compare& compare, const_iterator pos, It begin, It end)
         {
             while (begin != end)
@@ -443,7 +678,10 @@ namespace btree::detail
                 if (ndata.size() > ndata.capacity() / 2)
                 {
                     --size_;
-                    if (ndata.erase(allocator, ndata.begin() + it.kindex_) == ndata.end())
+                    update_count(node.node()->parent, -1);
+                    // Operands of == are unsequenced, so erase first and compare the index (split vector end() would be stale).
+                    ndata.erase(allocator, ndata.begin() + it.kindex_);
+                    if (it.kindex_ == ndata.size())
                     {
                         auto right = get_right(node);
                         if (right)
@@ -461,8 +699,10 @@ namespace btree::detail
                     auto kindex = find_key_index(compare, n.get_keys(), key);
 
                     --size_;
+                    update_count(n.node()->parent, -1);
                     auto ndata = n.get_data();
-                    if (ndata.erase(allocator, ndata.begin() + kindex) == ndata.end())
+                    ndata.erase(allocator, ndata.begin() + kindex);
+                    if (kindex == ndata.size())
                     {
                         auto right = get_right(n);
                         if (right)
@@ -477,7 +717,8 @@ namespace btree::detail
             else
             {
                 --size_;
-                if (ndata.erase(allocator, ndata.begin() + it.kindex_) == ndata.end())
+                ndata.erase(allocator, ndata.begin() + it.kindex_);
+                if (it.kindex_ == ndata.size())
                 {
                     if (empty())
                     {
@@ -492,6 +733,94 @@ namespace btree::detail
             }
         }
 
+        // Erases [first, last). Ranges covering most of the container rebuild the remaining elements bottom-up and
+        // free the old nodes wholesale. Otherwise fully covered value nodes are unlinked as a whole and the boundary
+        // nodes are trimmed in runs, so rebalancing runs per node instead of per element.
+        template < typename AllocatorT > iterator erase(AllocatorT&& allocator, const Compare& compare, const_iterator first, const_iterator last)
+        {
+            auto count = count_range(first, last);
+            if (count == 0)
+            {
+                return last;
+            }
+
+            if (count == size_)
+            {
+                clear(allocator);
+                return end();
+            }
+
+            if (size_ - count <= count)
+            {
+                if (last == end())
+                {
+                    erase_rebuild(allocator, first, last, size_ - count);
+                    return end();
+                }
+
+                key_type key = value_type_traits_type::get_key(*last);
+                erase_rebuild(allocator, first, last, size_ - count);
+                return find(compare, key);
+            }
+
+            iterator it = first;
+            while (count)
+            {
+                auto node = desc(it.node_);
+                auto ndata = node.get_data();
+
+                if (it.kindex_ == 0 && count >= ndata.size() && node.get_parent())
+                {
+                    auto right = get_right(node);
+                    count -= ndata.size();
+                    erase_node(allocator, compare, node);
+                    it = right ? iterator(right, 0) : end();
+                    continue;
+                }
+
+                // Elements that can be removed from the node without rebalancing.
+                size_type spare = ndata.size();
+                if (node.get_parent())
+                {
+                    spare = ndata.size() > ndata.capacity() / 2 ? ndata.size() - ndata.capacity() / 2 : 0;
+                }
+
+                auto n = std::min(std::min(count, spare), static_cast< size_type >(ndata.size() - it.kindex_));
+                if (n > 1)
+                {
+                    ndata.erase(allocator, ndata.begin() + it.kindex_, ndata.begin() + it.kindex_ + n);
+                    size_ -= n;
+                    count -= n;
+                    update_count(node.node()->parent, -static_cast< std::ptrdiff_t >(n));
+
+                    if (it.kindex_ == node.get_data().size())
+                    {
+                        auto right = get_right(node);
+                        it = right ? iterator(right, 0) : end();
+                    }
+                }
+                else
+                {
+                    it = erase(allocator, compare, it);
+                    --count;
+                }
+            }
+
+            return it;
+        }
+
+        template < typename AllocatorT > size_type erase_range(AllocatorT&& allocator, const Compare& compare, const key_type& lo, const key_type& hi)
+        {
+            if (!compare(lo, hi))
+            {
+                return 0;
+            }
+
+            auto size = size_;
+            erase(allocator, compare, lower_bound(compare, lo), lower_bound(compare, hi));
+            return size - size_;
+        }
+
         size_type size() const noexcept { return size_; }
         bool empty() const noexcept { return size_ == 0; }
 
@@ -578,6 +907,304 @@ namespace btree::detail
             return emplace(allocator, compare, std::move(value));
         }
 
+        template < typename It > static bool is_sorted_unique(const Compare& compare, It begin, It end)
+        {
+            return std::adjacent_find(begin, end, [&](const auto& lhs, const auto& rhs)
+            {
+                return !compare(value_type_traits_type::get_key(lhs), value_type_traits_type::get_key(rhs));
+            }) == end;
+        }
+
+        struct bulk_level
+        {
+            internal_node* node;
+            size_type remaining;
+            size_type needed;
+            size_type added;
+        };
+
+        // Number of elements for the next node so that all nodes on a level have at least Dim and at most 2 * Dim elements.
+        template < size_type Dim > static size_type bulk_chunk(size_type remaining, size_type target)
+        {
+            if (remaining <= target)
+            {
+                return remaining;
+            }
+            else if (remaining - target >= Dim)
+            {
+                return target;
+            }
+            else if (remaining <= 2 * Dim)
+            {
+                return remaining;
+            }
+            else
+            {
+                return remaining / 2;
+            }
+        }
+
+        template < size_type Dim > static size_type bulk_count(size_type count, size_type target)
+        {
+            size_type nodes = 0;
+            while (count)
+            {
+                count -= bulk_chunk< Dim >(count, target);
+                ++nodes;
+            }
+
+            return nodes;
+        }
+
+        template < size_type Dim > static size_type bulk_target(double fill_factor)
+        {
+            return std::clamp(static_cast< size_type >(fill_factor * 2 * Dim + 0.5), Dim, 2 * Dim);
+        }
+
+        // Walks both sorted sequences and builds the union bottom-up, moving the elements out of the old nodes.
+        template < typename AllocatorT, typename It > void merge_sorted(AllocatorT& allocator, const Compare& compare, It begin, It end, double fill_factor)
+        {
+            // Size of the union is needed up-front to lay out the levels.
+            size_type count = 0;
+            {
+                auto lit = this->begin();
+                auto lend = this->end();
+                auto rit = begin;
+                while (lit != lend && rit != end)
+                {
+                    const auto& lkey = value_type_traits_type::get_key(*lit);
+                    const auto& rkey = value_type_traits_type::get_key(*rit);
+                    if (compare(lkey, rkey))
+                    {
+                        ++lit;
+                    }
+                    else
+                    {
+                        if (!compare(rkey, lkey))
+                        {
+                            ++lit;
+                        }
+
+                        ++rit;
+                    }
+
+                    ++count;
+                }
+
+                count += static_cast< size_type >(std::distance(lit, lend) + std::distance(rit, end));
+            }
+
+            container_type old(std::move(*this));
+            auto lit = old.begin();
+            auto lend = old.end();
+
+            bulk_load(allocator, count, fill_factor, [&](auto& ndata)
+            {
+                if (lit != lend)
+                {
+                    auto ldata = desc(lit.node_).get_data();
+                    const auto& lkey = value_type_traits_type::get_key(ldata[lit.kindex_]);
+                    if (begin == end || compare(lkey, value_type_traits_type::get_key(*begin)))
+                    {
+                        ndata.emplace_back(allocator, std::move(ldata[lit.kindex_]));
+                        ++lit;
+                        return;
+                    }
+                    else if (!compare(value_type_traits_type::get_key(*begin), lkey))
+                    {
+                        // Existing element wins
+                        ndata.emplace_back(allocator, std::move(ldata[lit.kindex_]));
+                        ++lit;
+                        ++begin;
+                        return;
+                    }
+                }
+
+                ndata.emplace_back(allocator, value_type(*begin++));
+            });
+
+            BTREE_ASSERT(lit == lend);
+            BTREE_ASSERT(begin == end);
+            old.clear(allocator);
+        }
+
+        // Removes value node with all its elements, parent is rebalanced first so it can lose a key.
+        template < typename AllocatorT > void erase_node(AllocatorT& allocator, const Compare& compare, node_descriptor< value_node* > n)
+        {
+            BTREE_ASSERT(n.get_parent());
+
+            auto pkeys = n.get_parent().get_keys();
+            if (pkeys.size() <= pkeys.capacity() / 2)
+            {
+                size_type depth = depth_;
+                depth_check< false > dc(depth_, depth);
+                rebalance_erase(allocator, compare, depth - 1, n.get_parent());
+            }
+
+            auto count = n.get_data().size();
+            size_ -= count;
+            update_count(n.node()->parent, -static_cast< std::ptrdiff_t >(count));
+
+            if (first_node_ == n.node())
+            {
+                first_node_ = get_right(n);
+            }
+
+            auto nindex = get_index(n);
+            if (last_node_ == n.node())
+            {
+                last_node_ = std::get< 0 >(get_left(n, nindex));
+            }
+
+        #if defined(BTREE_VALUE_NODE_LR)
+            unlink_node(n);
+        #endif
+
+            remove_node(allocator, compare, depth_, n, nindex, nindex ? nindex - 1 : 0);
+            deallocate_node(allocator, n);
+        }
+
+        template < typename AllocatorT > void erase_rebuild(AllocatorT& allocator, const_iterator first, const_iterator last, size_type count)
+        {
+            container_type old(std::move(*this));
+            auto lit = old.begin();
+
+            bulk_load(allocator, count, 1.0, [&](auto& ndata)
+            {
+                if (lit == first)
+                {
+                    lit = last;
+                }
+
+                auto ldata = desc(lit.node_).get_data();
+                ndata.emplace_back(allocator, std::move(ldata[lit.kindex_]));
+                ++lit;
+            });
+
+            old.clear(allocator);
+        }
+
+        size_type count_range(const_iterator first, const_iterator last) const
+        {
+        #if defined(BTREE_INTERNAL_NODE_COUNT)
+            return distance(first, last);
+        #else
+            size_type count = 0;
+            for (; first != last; ++first)
+            {
+                ++count;
+            }
+
+            return count;
+        #endif
+        }
+
+        template < typename AllocatorT, typename Fn > void bulk_load(AllocatorT& allocator, size_type count, double fill_factor, Fn&& next)
+        {
+            BTREE_ASSERT(empty());
+            BTREE_ASSERT(root_ == nullptr);
+
+            if (!count)
+            {
+                return;
+            }
+
+            const size_type vtarget = bulk_target< value_node::N >(fill_factor);
+            const size_type itarget = bulk_target< internal_node::N >(fill_factor);
+
+            // Determine the number of levels, level 0 are value nodes, the last level contains just root.
+            std::array< bulk_level, sizeof(size_type) * 8 > levels;
+            size_type depth = 1;
+            size_type nodes = bulk_count< value_node::N >(count, vtarget);
+            while (nodes > 1)
+            {
+                levels[depth++] = { nullptr, nodes, 0, 0 };
+                nodes = bulk_count< internal_node::N >(nodes, itarget);
+            }
+
+            value_node* prev = nullptr;
+            size_type remaining = count;
+            while (remaining)
+            {
+                auto chunk = bulk_chunk< value_node::N >(remaining, vtarget);
+                remaining -= chunk;
+
+                auto n = desc(allocate_node< value_node >(allocator));
+                auto ndata = n.get_data();
+                for (size_type i = 0; i < chunk; ++i)
+                {
+                    next(ndata);
+                }
+
+                if (prev)
+                {
+                #if defined(BTREE_VALUE_NODE_LR)
+                    link_node(desc(prev), n);
+                #endif
+                }
+                else
+                {
+                    first_node_ = n;
+                }
+
+                if (depth > 1)
+                {
+                    bulk_append(allocator, levels.data(), 1, depth, itarget, n, n.get_keys()[0]);
+                    update_count(n.node()->parent, static_cast< std::ptrdiff_t >(chunk));
+                }
+                else
+                {
+                    root_ = n;
+                }
+
+                prev = n;
+            }
+
+            last_node_ = prev;
+            size_ = count;
+            depth_ = depth;
+        }
+
+        // Appends child node to the right-most node on a level, creating new nodes up to root as needed.
+        template < typename AllocatorT > void bulk_append(AllocatorT& allocator, bulk_level* levels, size_type level, size_type depth, size_type target, node* child, const Key& key)
+        {
+            auto& state = levels[level];
+            if (state.needed == 0)
+            {
+                state.node = allocate_node< internal_node >(allocator);
+                state.needed = bulk_chunk< internal_node::N >(state.remaining, target);
+                state.remaining -= state.needed;
+                state.added = 0;
+
+                if (level + 1 < depth)
+                {
+                    bulk_append(allocator, levels, level + 1, depth, target, state.node, key);
+                }
+                else
+                {
+                    BTREE_ASSERT(state.remaining == 0);
+                    root_ = state.node;
+                }
+            }
+
+            auto in = desc(state.node);
+            if (state.added == 0)
+            {
+                in.template get_children< node* >().emplace_back(allocator, child);
+            }
+            else
+            {
+                // Children count is derived from keys, so add separator first.
+                in.get_keys().emplace_back(allocator, key);
+                in.template get_children< node* >()[static_cast< node_size_type >(state.added)] = child;
+            }
+
+            set_parent(level == 1, child, state.node);
+
+            --state.needed;
+            ++state.added;
+        }
+
         std::tuple< node_descriptor< value_node* >, node_size_type > find_value_node(const Compare& compare, node* n, const key_type& key) const
         {
             size_type depth = depth_;
@@ -604,6 +1231,77 @@ namespace btree::detail
             return { node_cast<value_node*>(n), nindex };
         }
 
+        template < typename It, typename Fn > void search_many(const Compare& compare, It begin, It end, Fn&& fn) const
+        {
+            BTREE_ASSERT(root_);
+
+            // Path from root to the current value node, each node with the nearest separator on its right.
+            std::array< node*, sizeof(size_type) * 8 > nodes;
+            std::array< const key_type*, sizeof(size_type) * 8 > upper;
+            nodes[0] = root_;
+            upper[0] = nullptr;
+
+            size_type leaf = depth_ - 1;
+            size_type level = 0;
+            for (; begin != end; ++begin)
+            {
+                const key_type& key = *begin;
+                while (level > 0 && upper[level] && !compare(key, *upper[level]))
+                {
+                    --level;
+                }
+
+                for (; level < leaf; ++level)
+                {
+                    auto in = desc(node_cast<internal_node*>(nodes[level]));
+
+                    auto nkeys = in.get_keys();
+                    auto kindex = find_key_index(compare, nkeys, key);
+                    node_size_type nindex = kindex;
+                    if (kindex != nkeys.size() && key == nkeys[kindex])
+                    {
+                        ++nindex;
+                    }
+
+                    upper[level + 1] = nindex < nkeys.size() ? &nkeys[nindex] : upper[level];
+                    nodes[level + 1] = in.template get_children< node* >()[nindex];
+                }
+
+                auto vn = desc(node_cast<value_node*>(nodes[leaf]));
+                fn(vn, find_key_index(compare, vn.get_keys(), key), key);
+            }
+        }
+
+        // Returns value node for a key together with the nearest separator on the right (nullptr for the right edge).
+        std::tuple< node_descriptor< value_node* >, const key_type* > find_value_node_bound(const Compare& compare, const key_type& key) const
+        {
+            node* n = root_;
+            const key_type* upper = nullptr;
+            size_type depth = depth_;
+            BTREE_ASSERT(depth_ > 0);
+            while (--depth)
+            {
+                auto in = desc(node_cast<internal_node*>(n));
+
+                auto nkeys = in.get_keys();
+                auto kindex = find_key_index(compare, nkeys, key);
+                node_size_type nindex = kindex;
+                if (kindex != nkeys.size() && key == nkeys[kindex])
+                {
+                    ++nindex;
+                }
+
+                if (nindex < nkeys.size())
+                {
+                    upper = &nkeys[nindex];
+                }
+
+                n = in.template get_children< node* >()[nindex];
+            }
+
+            return { node_cast<value_node*>(n), upper };
+        }
+
         iterator find(const Compare& compare, node* n, const key_type& key) const
         {
             auto [vn, vnindex] = find_value_node(compare, n, key);
@@ -671,24 +1369,14 @@ namespace btree::detail
 
             n.get_data().emplace(allocator, n.get_data().begin() + kindex, std::forward< T >(value));
             ++size_;
+            update_count(n.node()->parent, 1);
             return { iterator(n, kindex), true };
         }
 
         template < typename Descriptor > auto find_key_index(const Compare& compare, const fixed_vector< Key, Descriptor >& keys, const key_type& key) const
         {
             // Counts number of elements smaller than key
-            // TODO: better search
-                        
-            auto index = keys.begin();
-            for (; index != keys.end(); ++index)
-            {
-                if (!compare(*index, key))
-                {
-                    break;
-                }
-            }
-
-            return static_cast<node_size_type>(index - keys.begin());
+            return static_cast<node_size_type>(key_search< Key, Compare >::lower_bound(compare, keys.begin(), keys.size(), key));
         }       
 
         template < typename Node, typename Descriptor > static auto find_node_index(const fixed_vector< Node*, Descriptor >& nodes, const node* n)
@@ -765,11 +1453,58 @@ namespace btree::detail
             std::allocator_traits< decltype(alloc) >::deallocate(alloc, n.node(), 1);
         }
 
-        // TODO: check that returned reference is valid where split_key is used.
-        static const Key& split_key(node_descriptor< internal_node* > n)
+    #if defined(BTREE_INTERNAL_NODE_COUNT)
+        // Number of elements in the subtree of a node.
+        static size_type get_count(node* n, bool valuenode)
         {
-            BTREE_ASSERT(full(n));
-            return *(n.get_keys().begin() + internal_node::N);
+            return valuenode ? node_cast<value_node*>(n)->size : node_cast<internal_node*>(n)->count;
+        }
+
+        // Adds delta to all internal nodes on the path from p to root.
+        static void update_count(internal_node* p, std::ptrdiff_t delta)
+        {
+            for (; p; p = p->parent)
+            {
+                p->count += delta;
+            }
+        }
+
+        static void move_count(node_descriptor< internal_node* > source, node_descriptor< internal_node* > target, node* child, bool valuenode)
+        {
+            auto count = get_count(child, valuenode);
+            source.node()->count -= count;
+            target.node()->count += count;
+        }
+    #else
+        static void update_count(internal_node*, std::ptrdiff_t) {}
+        static void move_count(node_descriptor< internal_node* >, node_descriptor< internal_node* >, node*, bool) {}
+    #endif
+
+        // Inserting a key larger than any key in the tree.
+        bool is_append(const Compare& compare, const key_type& key) const
+        {
+            if (last_node_)
+            {
+                auto keys = desc(last_node_).get_keys();
+                return !keys.empty() && compare(keys.back(), key);
+            }
+
+            return false;
+        }
+
+        static bool is_right_edge(node_descriptor< internal_node* > n)
+        {
+            while (n.get_parent())
+            {
+                if (get_index(n) != n.get_parent().get_keys().size())
+                {
+                    return false;
+                }
+
+                n = n.get_parent();
+            }
+
+            return true;
         }
 
         template < typename Node > void link_node(node_descriptor< Node > lnode, node_descriptor< Node > rnode)
@@ -800,36 +1535,57 @@ namespace btree::detail
             }
         }
 
-        template < typename AllocatorT > std::tuple< node_descriptor< internal_node* >, const key_type > split_node(AllocatorT&& allocator, const Compare&, size_type depth, node_descriptor< internal_node* > lnode, const key_type&)
+        template < typename AllocatorT > std::tuple< node_descriptor< internal_node* >, const key_type > split_node(AllocatorT&& allocator, const Compare& compare, size_type depth, node_descriptor< internal_node* > lnode, const key_type& key)
         {
             BTREE_ASSERT(full(lnode));
             auto rnode = desc(allocate_node< internal_node >(allocator));
 
+            // Number of children that stay in lnode.
+            node_size_type split = internal_node::N;
+
+        #if defined(BTREE_INTERNAL_NODE_APPEND)
+            // Appending to the whole tree means we are on its right edge. Keep lnode nearly full and move just
+            // the last two children to rnode (internal node can't have less than one key), so append-only
+            // workloads do not leave internal nodes half empty.
+            if (is_append(compare, key))
+            {
+                split = 2 * internal_node::N - 2;
+            }
+        #endif
+
             auto lchildren = lnode.template get_children< node* >();
             auto rchildren = rnode.template get_children< node* >();
 
             BTREE_ASSERT(depth_ >= depth + 1);
-            rchildren.insert(allocator, rchildren.begin(), lchildren.begin() + internal_node::N, lchildren.end());
+            rchildren.insert(allocator, rchildren.begin(), lchildren.begin() + split, lchildren.end());
             std::for_each(rchildren.begin(), rchildren.end(), [&](auto& n) { set_parent(depth_ == depth + 1, n, rnode); });
 
             auto lkeys = lnode.get_keys();
             auto rkeys = rnode.get_keys();
 
-            auto begin = lkeys.begin() + internal_node::N;
+            auto begin = lkeys.begin() + split;
             rkeys.insert(allocator, rkeys.end(), std::make_move_iterator(begin), std::make_move_iterator(lkeys.end()));
 
             Key splitkey = std::move(*(begin - 1));
 
-            // Remove splitkey, too (begin - 1). Each node should end up with N-1 keys as split key will be propagated to parent node.
+            // Remove splitkey, too (begin - 1). Split key will be propagated to parent node.
             lkeys.erase(allocator, begin - 1, lkeys.end());
 
-            BTREE_ASSERT(lkeys.size() == internal_node::N - 1);
-            BTREE_ASSERT(lnode.template get_children< node* >().size() == internal_node::N);
-            BTREE_ASSERT(rkeys.size() == internal_node::N - 1);
-            BTREE_ASSERT(rnode.template get_children< node* >().size() == internal_node::N);
+            BTREE_ASSERT(lkeys.size() == split - 1);
+            BTREE_ASSERT(lnode.template get_children< node* >().size() == split);
+            BTREE_ASSERT(rkeys.size() == 2 * internal_node::N - 1 - split);
+            BTREE_ASSERT(rnode.template get_children< node* >().size() == 2 * internal_node::N - split);
             BTREE_ASSERT(lkeys.back() < splitkey);
             BTREE_ASSERT(rkeys.front() >= splitkey);
 
+        #if defined(BTREE_INTERNAL_NODE_COUNT)
+            for (auto child : rchildren)
+            {
+                rnode.node()->count += get_count(child, depth_ == depth + 1);
+            }
+            lnode.node()->count -= rnode.node()->count;
+        #endif
+
         #if defined(BTREE_INTERNAL_NODE_LR)
             link_node(lnode, rnode);
         #endif
@@ -1056,6 +1812,7 @@ namespace btree::detail
                     
                     tchildren.emplace(allocator, tchildren.begin(), schildren[skeys.size()]);
                     set_parent(depth_ == depth + 1, schildren[skeys.size()], target);
+                    move_count(source, target, schildren[skeys.size()], depth_ == depth + 1);
                                        
                     tkeys.emplace(allocator, tkeys.begin(), std::move(pkeys[pkindex]));
 
@@ -1071,6 +1828,7 @@ namespace btree::detail
                     tkeys.emplace(allocator, tkeys.end(), std::move(pkeys[pkindex]));
                     auto child = schildren[0];
                     set_parent(depth_ == depth + 1, child, target);
+                    move_count(source, target, child, depth_ == depth + 1);
                                                             
                     schildren.erase(allocator, schildren.begin());
                     tchildren.emplace(allocator, tchildren.end(), child);
@@ -1081,7 +1839,11 @@ namespace btree::detail
                     BTREE_ASSERT(verify_separator(compare, pkeys, tkeys.back(), pkeys[pkindex], skeys.front()));
                 }
                         
-                BTREE_ASSERT(tkeys.size() > tkeys.capacity() / 2);
+                BTREE_ASSERT(tkeys.size() > tkeys.capacity() / 2
+                #if defined(BTREE_INTERNAL_NODE_APPEND)
+                    || is_right_edge(target)
+                #endif
+                );
 
                 return true;
             }
@@ -1143,7 +1905,12 @@ namespace btree::detail
             auto skeys = source.get_keys();
             auto tkeys = target.get_keys();
 
+        #if defined(BTREE_INTERNAL_NODE_APPEND)
+            // Nodes on the right edge can have less than N - 1 keys.
+            if (tkeys.size() <= internal_node::N - 1 && tkeys.size() + skeys.size() < 2 * internal_node::N - 1)
+        #else
             if (tkeys.size() == internal_node::N - 1)
+        #endif
             {                
                 auto p = source.get_parent();
                 auto pkeys = p.get_keys();             
@@ -1174,6 +1941,10 @@ namespace btree::detail
                     tkeys.insert(allocator, tkeys.begin(), std::make_move_iterator(skeys.begin()), std::make_move_iterator(skeys.end()));                    
                 }
 
+            #if defined(BTREE_INTERNAL_NODE_COUNT)
+                target.node()->count += source.node()->count;
+            #endif
+
                 return true;
             }
 
@@ -1210,6 +1981,9 @@ namespace btree::detail
             #endif
 
                 root.get_keys().emplace_back(allocator, std::move(splitkey));
+            #if defined(BTREE_INTERNAL_NODE_COUNT)
+                root.node()->count = size_;
+            #endif
                 
                 if (root_ == last_node_)
                 {
@@ -1236,7 +2010,7 @@ namespace btree::detail
             {
                 BTREE_ASSERT(depth > 1);
                 depth_check< true > dc(depth_, depth);
-                rebalance_insert(allocator, compare, depth - 1, n.get_parent(), split_key(n.get_parent()));
+                rebalance_insert(allocator, compare, depth - 1, n.get_parent(), key);
                 
                 // Parent may changed, so fetch n's index again
                 nindex = get_index(n);
@@ -1571,6 +2345,10 @@ namespace btree::detail
 
                 BTREE_ASSERT(count_node == size());
             #endif
+
+            #if defined(BTREE_INTERNAL_NODE_COUNT)
+                BTREE_ASSERT(verify_count(root_, 1) == size());
+            #endif
             }
             else
             {
@@ -1582,6 +2360,26 @@ namespace btree::detail
             }
         }
 
+    #if defined(BTREE_INTERNAL_NODE_COUNT)
+        size_type verify_count(node* n, size_type level)
+        {
+            if (level == depth_)
+            {
+                return node_cast<value_node*>(n)->size;
+            }
+
+            auto in = desc(node_cast<internal_node*>(n));
+            size_type count = 0;
+            for (auto child : in.template get_children< node* >())
+            {
+                count += verify_count(child, level + 1);
+            }
+
+            BTREE_ASSERT(in.node()->count == count);
+            return count;
+        }
+    #endif
+
         template < typename Node > void verify_keys(const Compare& compare, node_descriptor< Node* > n)
         {
             auto nkeys = n.get_keys();
@@ -1685,7 +2483,11 @@ namespace btree::detail
 
         bool verify_node(const Compare& compare, node_descriptor< internal_node* > n)
         {
-            if (n.node() != root_)
+            if (n.node() != root_
+            #if defined(BTREE_INTERNAL_NODE_APPEND)
+                && !is_right_edge(n)
+            #endif
+                )
             {
                 BTREE_ASSERT(internal_node::N - 1 <= n.node()->size && n.node()->size <= 2 * internal_node::N - 1);
             }
@@ -1724,6 +2526,10 @@ namespace btree::detail
         alignas(Key) uint8_t keys[(2 * N - 1) * sizeof(Key)];
         alignas(node*) uint8_t children[2 * N * sizeof(node*)];
         internal_node< Key, SizeType, N >* parent;
+    #if defined(BTREE_INTERNAL_NODE_COUNT)
+        // Number of elements in the subtree.
+        std::size_t count;
+    #endif
     #if defined(BTREE_INTERNAL_NODE_LR)
         internal_node< Key, SizeType, N >* left;
         internal_node< Key, SizeType, N >* right;
@@ -93,15 +93,9 @@ namespace btree::detail
             assert(this->begin() <= from && from <= to);
             assert(from <= to && to <= this->end());
 
-            if (to == this->end())
-            {
-                destroy(alloc, from, to);
-                this->set_size(this->size() - static_cast<size_type>(to - from));
-            }
-            else
-            {
-                std::abort(); // TODO
-            }
+            auto end = std::move(to, this->end(), from);
+            destroy(alloc, end, this->end());
+            this->set_size(this->size() - static_cast<size_type>(to - from));
         }
                
         template < typename Allocator > void clear(Allocator& alloc)
@@ -258,7 +252,7 @@ namespace btree::detail
             assert(this->begin() <= it && it < this->end());
 
             bool last = it == this->end() - 1;
-            copy(it, it + 1, static_cast< size_type >(this->end() - it - 1));
+            move(it, it + 1, static_cast< size_type >(this->end() - it - 1));
             this->set_size(this->size() - 1);
             return last ? this->end() : it;
         }
@@ -268,14 +262,8 @@ namespace btree::detail
             assert(this->begin() <= from && from <= to);
             assert(from <= to && to <= this->end());
 
-            if (to == this->end())
-            {                
-                this->set_size(this->size() - static_cast<size_type>(to - from));
-            }
-            else
-            {
-                std::abort(); // TODO
-            }
+            move(from, to, static_cast< size_type >(this->end() - to));
+            this->set_size(this->size() - static_cast<size_type>(to - from));
         }
 
         template < typename Allocator, typename U > void insert(Allocator& alloc, iterator it, std::move_iterator< U > from, std::move_iterator< U > to)
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <algorithm>
+#include <bitset>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+
+//#define BTREE_KEY_SEARCH_SCALAR
+
+#if !defined(BTREE_KEY_SEARCH_SCALAR)
+    #if defined(__AVX2__)
+        #define BTREE_KEY_SEARCH_AVX2
+    #endif
+    #if defined(__SSE4_2__) || defined(__AVX2__)
+        #define BTREE_KEY_SEARCH_SSE42
+    #endif
+    #if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        #define BTREE_KEY_SEARCH_SSE2
+    #endif
+#endif
+
+#if defined(BTREE_KEY_SEARCH_AVX2) || defined(BTREE_KEY_SEARCH_SSE42)
+    #include <immintrin.h>
+#elif defined(BTREE_KEY_SEARCH_SSE2)
+    #include <emmintrin.h>
+#endif
+
+namespace btree::detail
+{
+    // Counts number of keys in a sorted node array that are smaller than key, that is, the lower bound index.
+    // Integral keys of 4 or 8 bytes compared with std::less use vector compares, everything else uses scalar loop.
+    template < typename Key, typename Compare, typename = void > struct key_search
+    {
+        static constexpr bool vectorized = false;
+
+        template < typename SizeType > static SizeType lower_bound(const Compare& compare, const Key* keys, SizeType size, const Key& key)
+        {
+            // Wide nodes are searched with a binary search.
+            if (size > 32)
+            {
+                return static_cast< SizeType >(std::lower_bound(keys, keys + size, key, compare) - keys);
+            }
+
+            SizeType index = 0;
+            for (; index < size; ++index)
+            {
+                if (!compare(keys[index], key))
+                {
+                    break;
+                }
+            }
+
+            return index;
+        }
+    };
+
+    template < typename Key > struct key_search_traits
+    {
+        static constexpr bool integral = std::is_integral_v< Key > && !std::is_same_v< Key, bool >;
+
+        static constexpr bool value = integral && (
+        #if defined(BTREE_KEY_SEARCH_SSE2)
+            sizeof(Key) == 4 ||
+        #endif
+        #if defined(BTREE_KEY_SEARCH_SSE42)
+            sizeof(Key) == 8 ||
+        #endif
+            false
+        );
+    };
+
+#if defined(BTREE_KEY_SEARCH_SSE2)
+    template < typename Key > struct key_search< Key, std::less< Key >, std::enable_if_t< key_search_traits< Key >::value > >
+    {
+        static constexpr bool vectorized = true;
+
+        template < typename SizeType > static SizeType lower_bound(const std::less< Key >&, const Key* keys, SizeType size, const Key& key)
+        {
+            // Wide nodes are narrowed down with a binary search first, the remaining window is scanned.
+            SizeType first = 0;
+            while (size - first > 64)
+            {
+                SizeType middle = static_cast< SizeType >(first + (size - first) / 2);
+                if (keys[middle] < key)
+                {
+                    first = static_cast< SizeType >(middle + 1);
+                }
+                else
+                {
+                    size = middle;
+                }
+            }
+
+            return static_cast< SizeType >(first + scan(keys + first, static_cast< SizeType >(size - first), key));
+        }
+
+    private:
+        template < typename SizeType > static SizeType scan(const Key* keys, SizeType size, const Key& key)
+        {
+            SizeType index = 0;
+
+        #if defined(BTREE_KEY_SEARCH_AVX2)
+            {
+                constexpr SizeType lanes = 32 / sizeof(Key);
+                const __m256i bias = set1_256(sign_bit());
+                const __m256i needle = _mm256_xor_si256(set1_256(static_cast< int64_t >(key)), bias);
+
+                for (; index + lanes <= size; index += lanes)
+                {
+                    __m256i data = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast< const __m256i* >(keys + index)), bias);
+                    auto mask = movemask_256(cmpgt_256(needle, data));
+                    if (mask != full_mask(lanes))
+                    {
+                        return static_cast< SizeType >(index + count(mask));
+                    }
+                }
+            }
+        #endif
+
+            {
+                constexpr SizeType lanes = 16 / sizeof(Key);
+                const __m128i bias = set1_128(sign_bit());
+                const __m128i needle = _mm_xor_si128(set1_128(static_cast< int64_t >(key)), bias);
+
+                for (; index + lanes <= size; index += lanes)
+                {
+                    __m128i data = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast< const __m128i* >(keys + index)), bias);
+                    auto mask = movemask_128(cmpgt_128(needle, data));
+                    if (mask != full_mask(lanes))
+                    {
+                        return static_cast< SizeType >(index + count(mask));
+                    }
+                }
+            }
+
+            for (; index < size; ++index)
+            {
+                if (!(keys[index] < key))
+                {
+                    break;
+                }
+            }
+
+            return index;
+        }
+
+        // Vector compares are signed, unsigned keys are biased by the sign bit so the ordering is preserved.
+        static constexpr int64_t sign_bit()
+        {
+            if constexpr (std::is_signed_v< Key >)
+            {
+                return 0;
+            }
+            else if constexpr (sizeof(Key) == 4)
+            {
+                return static_cast< int32_t >(0x80000000u);
+            }
+            else
+            {
+                return static_cast< int64_t >(0x8000000000000000ull);
+            }
+        }
+
+        static constexpr unsigned full_mask(size_t lanes) { return (1u << lanes) - 1; }
+        static size_t count(unsigned mask) { return std::bitset< 8 >(mask).count(); }
+
+        static __m128i set1_128(int64_t value)
+        {
+            if constexpr (sizeof(Key) == 4) return _mm_set1_epi32(static_cast< int32_t >(value));
+            else return _mm_set1_epi64x(value);
+        }
+
+        static __m128i cmpgt_128(__m128i lhs, __m128i rhs)
+        {
+            if constexpr (sizeof(Key) == 4) return _mm_cmpgt_epi32(lhs, rhs);
+        #if defined(BTREE_KEY_SEARCH_SSE42)
+            else return _mm_cmpgt_epi64(lhs, rhs);
+        #endif
+        }
+
+        static unsigned movemask_128(__m128i mask)
+        {
+            if constexpr (sizeof(Key) == 4) return static_cast< unsigned >(_mm_movemask_ps(_mm_castsi128_ps(mask)));
+            else return static_cast< unsigned >(_mm_movemask_pd(_mm_castsi128_pd(mask)));
+        }
+
+    #if defined(BTREE_KEY_SEARCH_AVX2)
+        static __m256i set1_256(int64_t value)
+        {
+            if constexpr (sizeof(Key) == 4) return _mm256_set1_epi32(static_cast< int32_t >(value));
+            else return _mm256_set1_epi64x(value);
+        }
+
+        static __m256i cmpgt_256(__m256i lhs, __m256i rhs)
+        {
+            if constexpr (sizeof(Key) == 4) return _mm256_cmpgt_epi32(lhs, rhs);
+            else return _mm256_cmpgt_epi64(lhs, rhs);
+        }
+
+        static unsigned movemask_256(__m256i mask)
+        {
+            if constexpr (sizeof(Key) == 4) return static_cast< unsigned >(_mm256_movemask_ps(_mm256_castsi256_ps(mask)));
+            else return static_cast< unsigned >(_mm256_movemask_pd(_mm256_castsi256_pd(mask)));
+        }
+    #endif
+    };
+#endif
+}
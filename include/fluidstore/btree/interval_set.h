@@ -0,0 +1,415 @@
+#pragma once
+
+#include <fluidstore/btree/map.h>
+
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
+
+namespace btree
+{
+    // Set of integers stored as closed runs [lo, hi] in a btree keyed by lo. Dense sequences like dot counters
+    // take a single run, so memory and merges scale with the number of runs and not with the number of elements.
+    // Iterators visit the elements, not the runs.
+    template < typename T > class interval_set_base
+    {
+        static_assert(std::is_integral_v< T >);
+
+        using runs_type = map_base< T, T >;
+        using run_iterator = typename runs_type::iterator;
+
+    public:
+        using value_type = T;
+        using key_type = T;
+        using size_type = std::size_t;
+
+        struct iterator
+        {
+            friend interval_set_base< T >;
+
+            using iterator_category = std::bidirectional_iterator_tag;
+            using difference_type = std::ptrdiff_t;
+            using value_type = T;
+            using pointer = const T*;
+            using reference = T;
+
+            iterator() = default;
+
+            iterator(run_iterator it, run_iterator end, T value)
+                : it_(it)
+                , end_(end)
+                , value_(value)
+            {}
+
+            bool operator == (const iterator& rhs) const { return it_ == rhs.it_ && value_ == rhs.value_; }
+            bool operator != (const iterator& rhs) const { return !(*this == rhs); }
+
+            reference operator*() const { return value_; }
+            pointer operator->() const { return &value_; }
+
+            iterator& operator++()
+            {
+                if (value_ == (*it_).second)
+                {
+                    value_ = ++it_ != end_ ? (*it_).first : T();
+                }
+                else
+                {
+                    ++value_;
+                }
+
+                return *this;
+            }
+
+            iterator operator++(int)
+            {
+                iterator it = *this;
+                ++*this;
+                return it;
+            }
+
+            iterator& operator--()
+            {
+                if (it_ == end_ || value_ == (*it_).first)
+                {
+                    value_ = (*--it_).second;
+                }
+                else
+                {
+                    --value_;
+                }
+
+                return *this;
+            }
+
+            iterator operator--(int)
+            {
+                iterator it = *this;
+                --*this;
+                return it;
+            }
+
+            // Bounds of the run the iterator points into.
+            T run_first() const { return (*it_).first; }
+            T run_last() const { return (*it_).second; }
+
+        private:
+            run_iterator it_;
+            run_iterator end_;
+            T value_;
+        };
+
+        using const_iterator = iterator;
+
+        interval_set_base() = default;
+
+        interval_set_base(interval_set_base< T >&& other)
+            : runs_(std::move(other.runs_))
+            , size_(other.size_)
+        {
+            other.size_ = 0;
+        }
+
+        interval_set_base< T >& operator = (interval_set_base< T >&& other)
+        {
+            std::swap(runs_, other.runs_);
+            std::swap(size_, other.size_);
+            return *this;
+        }
+
+        iterator begin() const { return make_iterator(runs_.begin()); }
+        iterator end() const { return iterator(runs_.end(), runs_.end(), T()); }
+
+        size_type size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+
+        // Number of runs, the amount of memory used is proportional to this.
+        size_type runs() const { return runs_.size(); }
+
+        iterator find(const T& value) const
+        {
+            auto it = find_run(value);
+            return it != runs_.end() ? iterator(it, runs_.end(), value) : end();
+        }
+
+        template < typename AllocatorT > std::pair< iterator, bool > emplace(AllocatorT& allocator, const T& value)
+        {
+            auto it = find(value);
+            if (it != end())
+            {
+                return { it, false };
+            }
+
+            insert(allocator, value, value);
+            return { find(value), true };
+        }
+
+        // Inserts run [lo, hi], joining it with overlapping and adjacent runs. Returns number of new elements.
+        template < typename AllocatorT > size_type insert(AllocatorT& allocator, T lo, T hi)
+        {
+            BTREE_ASSERT(lo <= hi);
+
+            auto first = runs_.lower_bound(compare_type(), lo);
+            if (first != runs_.begin())
+            {
+                auto prev = first;
+                if (adjacent((*--prev).second, lo))
+                {
+                    first = prev;
+                }
+            }
+
+            T nlo = lo;
+            T nhi = hi;
+            size_type covered = 0;
+            size_type joined = 0;
+            auto last = first;
+            for (; last != runs_.end() && adjacent(nhi, (*last).first); ++last, ++joined)
+            {
+                nlo = std::min(nlo, (*last).first);
+                nhi = std::max(nhi, (*last).second);
+                covered += count((*last).first, (*last).second);
+            }
+
+            size_type added = count(nlo, nhi) - covered;
+            if (added == 0)
+            {
+                return 0;
+            }
+
+            if (joined && (*first).first == nlo)
+            {
+                // Extending the first run keeps its key, so its upper bound can be updated in place.
+                if (joined > 1)
+                {
+                    auto next = first;
+                    runs_.erase(allocator, compare_type(), ++next, last);
+                    first = runs_.find(compare_type(), nlo);
+                }
+
+                (*first).second = nhi;
+            }
+            else
+            {
+                if (joined)
+                {
+                    runs_.erase(allocator, compare_type(), first, last);
+                }
+
+                runs_.emplace(allocator, compare_type(), nlo, nhi);
+            }
+
+            size_ += added;
+            return added;
+        }
+
+        // Inserts sorted elements, consecutive elements are inserted as one run.
+        template < typename AllocatorT, typename It > void insert_sorted(AllocatorT& allocator, It begin, It end)
+        {
+            while (begin != end)
+            {
+                T lo = *begin;
+                T hi = lo;
+                while (++begin != end && *begin == hi + 1)
+                {
+                    ++hi;
+                }
+
+                insert(allocator, lo, hi);
+            }
+        }
+
+        template < typename AllocatorT > void insert_sorted(AllocatorT& allocator, iterator begin, iterator end)
+        {
+            while (begin != end)
+            {
+                T lo = *begin;
+                T hi = begin.run_last();
+                if (end.it_ == begin.it_)
+                {
+                    hi = *end - 1;
+                    begin = end;
+                }
+                else
+                {
+                    begin = make_iterator(++begin.it_, begin.end_);
+                }
+
+                insert(allocator, lo, hi);
+            }
+        }
+
+        template < typename AllocatorT > void insert_sorted(AllocatorT& allocator, const interval_set_base< T >& other)
+        {
+            for (auto&& [lo, hi] : other.runs_)
+            {
+                insert(allocator, lo, hi);
+            }
+        }
+
+        template < typename AllocatorT > iterator erase(AllocatorT& allocator, iterator it)
+        {
+            BTREE_ASSERT(it != end());
+
+            T value = *it;
+            T lo = (*it.it_).first;
+            T hi = (*it.it_).second;
+            --size_;
+
+            if (lo == hi)
+            {
+                return make_iterator(runs_.erase(allocator, compare_type(), it.it_));
+            }
+            else if (value == hi)
+            {
+                (*it.it_).second = hi - 1;
+                return make_iterator(++it.it_);
+            }
+            else if (value == lo)
+            {
+                runs_.erase(allocator, compare_type(), it.it_);
+            }
+            else
+            {
+                (*it.it_).second = value - 1;
+            }
+
+            runs_.emplace(allocator, compare_type(), value + 1, hi);
+            return find(value + 1);
+        }
+
+        // Erases elements in [first, last). Runs inside the range are removed at once, at most two runs are trimmed.
+        template < typename AllocatorT > iterator erase(AllocatorT& allocator, iterator first, iterator last)
+        {
+            if (first == last)
+            {
+                return last;
+            }
+
+            bool bounded = last != end();
+            T lo = *first;
+            T hi = bounded ? *last - 1 : *--end();
+
+            auto rfirst = first.it_;
+            auto rlast = rfirst;
+            T left = (*rfirst).first;
+            T right = hi;
+            for (; rlast != runs_.end() && (*rlast).first <= hi; ++rlast)
+            {
+                right = (*rlast).second;
+                size_ -= count(std::max(lo, (*rlast).first), std::min(hi, (*rlast).second));
+            }
+
+            runs_.erase(allocator, compare_type(), rfirst, rlast);
+            if (left < lo)
+            {
+                runs_.emplace(allocator, compare_type(), left, lo - 1);
+            }
+
+            if (right > hi)
+            {
+                runs_.emplace(allocator, compare_type(), hi + 1, right);
+            }
+
+            return bounded ? find(hi + 1) : end();
+        }
+
+        template < typename AllocatorT > size_type erase(AllocatorT& allocator, const T& value)
+        {
+            auto it = find(value);
+            if (it != end())
+            {
+                erase(allocator, it);
+                return 1;
+            }
+
+            return 0;
+        }
+
+        template < typename AllocatorT > void clear(AllocatorT& allocator)
+        {
+            runs_.clear(allocator);
+            size_ = 0;
+        }
+
+        // Writes elements of this set that are not in other to out, skipping whole runs where possible.
+        template < typename OutputIt > OutputIt difference(const interval_set_base< T >& other, OutputIt out) const
+        {
+            auto rit = other.runs_.begin();
+            for (auto&& [lo, hi] : runs_)
+            {
+                while (rit != other.runs_.end() && (*rit).second < lo)
+                {
+                    ++rit;
+                }
+
+                T value = lo;
+                bool covered = false;
+                for (auto it = rit; it != other.runs_.end() && (*it).first <= hi; ++it)
+                {
+                    if (value < (*it).first)
+                    {
+                        out = copy_run(value, (*it).first - 1, out);
+                    }
+
+                    if ((*it).second >= hi)
+                    {
+                        covered = true;
+                        break;
+                    }
+
+                    value = (*it).second + 1;
+                }
+
+                if (!covered)
+                {
+                    out = copy_run(value, hi, out);
+                }
+            }
+
+            return out;
+        }
+
+    private:
+        using compare_type = std::less< T >;
+
+        static size_type count(T lo, T hi) { return static_cast< size_type >(hi - lo) + 1; }
+
+        template < typename OutputIt > static OutputIt copy_run(T lo, T hi, OutputIt out)
+        {
+            for (;; ++lo)
+            {
+                *out++ = lo;
+                if (lo == hi)
+                {
+                    return out;
+                }
+            }
+        }
+
+        // True if run ending at hi and run starting at lo overlap or touch.
+        static bool adjacent(T hi, T lo) { return hi >= lo || hi + 1 == lo; }
+
+        iterator make_iterator(run_iterator it) const { return make_iterator(it, runs_.end()); }
+        static iterator make_iterator(run_iterator it, run_iterator end) { return iterator(it, end, it != end ? (*it).first : T()); }
+
+        run_iterator find_run(const T& value) const
+        {
+            auto it = runs_.lower_bound(compare_type(), value);
+            if (it != runs_.end() && (*it).first == value)
+            {
+                return it;
+            }
+
+            if (it != runs_.begin() && (*--it).second >= value)
+            {
+                return it;
+            }
+
+            return runs_.end();
+        }
+
+        runs_type runs_;
+        size_type size_ = 0;
+    };
+}
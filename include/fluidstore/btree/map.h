@@ -109,12 +109,29 @@ namespace btree
 
         map() = default;
 
-        template < typename AllocatorT > map(AllocatorT&& allocator)
+        template < typename AllocatorT, typename = std::enable_if_t< !std::is_same_v< std::decay_t< AllocatorT >, map< Key, Value, Compare, Allocator, NodeSizeType, N, InternalNodeType, ValueNodeType > > > > map(AllocatorT&& allocator)
             : detail::compressed_base< Allocator >(std::forward< AllocatorT >(allocator))
         {}
 
         map(map< Key, Value, Compare, Allocator, NodeSizeType, N, InternalNodeType, ValueNodeType >&& other) = default;
 
+        map(const map< Key, Value, Compare, Allocator, NodeSizeType, N, InternalNodeType, ValueNodeType >& other)
+            : detail::compressed_base< Allocator >(other.get_allocator())
+            , detail::compressed_base< Compare >(other.key_comp())
+        {
+            BTREE_CHECK(base_type::assign(this->get_allocator(), other));
+        }
+
+        map< Key, Value, Compare, Allocator, NodeSizeType, N, InternalNodeType, ValueNodeType >& operator = (const map< Key, Value, Compare, Allocator, NodeSizeType, N, InternalNodeType, ValueNodeType >& other)
+        {
+            if (this != &other)
+            {
+                BTREE_CHECK(base_type::assign(this->get_allocator(), other));
+            }
+
+            return *this;
+        }
+
         ~map()
         {
             clear();
@@ -123,6 +140,18 @@ namespace btree
         iterator find(const key_type& key) { return base_type::find(this->key_comp(), key); }
         const_iterator find(const key_type& key) const { return base_type::find(this->key_comp(), key); }
 
+        // Batched lookups of sorted keys, one iterator is written to out for each key.
+        template < typename It, typename OutputIt > OutputIt find_many(It begin, It end, OutputIt out) const { return base_type::find_many(this->key_comp(), begin, end, out); }
+        template < typename It, typename OutputIt > OutputIt lower_bound_many(It begin, It end, OutputIt out) const { return base_type::lower_bound_many(this->key_comp(), begin, end, out); }
+
+    #if defined(BTREE_INTERNAL_NODE_COUNT)
+        // Order statistics in O(log n): rank is the number of smaller keys, nth is the inverse.
+        size_type rank(const key_type& key) const { return base_type::rank(this->key_comp(), key); }
+        iterator nth(size_type index) const { return base_type::nth(index); }
+        size_type index(const_iterator it) const { return base_type::index(it); }
+        size_type distance(const_iterator first, const_iterator last) const { return base_type::distance(first, last); }
+    #endif
+
         std::pair< iterator, bool > insert(const value_type& value)
         {
             BTREE_CHECK_RETURN(base_type::emplace(this->get_allocator(), this->key_comp(), value));
@@ -148,6 +177,12 @@ namespace btree
             BTREE_CHECK(base_type::insert(this->get_allocator(), this->key_comp(), begin, end));
         }
 
+        // Range has to be sorted and unique, empty container is built bottom-up in a linear time.
+        template < typename It > void insert_sorted(It begin, It end, double fill_factor = 1.0)
+        {
+            BTREE_CHECK(base_type::insert_sorted(this->get_allocator(), this->key_comp(), begin, end, fill_factor));
+        }
+
         // TODO
         // void insert(initializer_list<value_type> il);
 
@@ -161,6 +196,17 @@ namespace btree
             BTREE_CHECK_RETURN(base_type::erase(this->get_allocator(), this->key_comp(), it));
         }
 
+        iterator erase(const_iterator first, const_iterator last)
+        {
+            BTREE_CHECK_RETURN(base_type::erase(this->get_allocator(), this->key_comp(), first, last));
+        }
+
+        // Erases keys in [lo, hi), returns number of erased elements.
+        size_type erase_range(const key_type& lo, const key_type& hi)
+        {
+            BTREE_CHECK_RETURN(base_type::erase_range(this->get_allocator(), this->key_comp(), lo, hi));
+        }
+
         void clear() noexcept
         {
             // TODO: missing test
@@ -185,4 +231,23 @@ namespace btree
         auto get_allocator() const { return detail::compressed_base< Allocator >::get(); }
         auto key_comp() const { return detail::compressed_base< Compare >::get(); }
     };
+
+    // Map with nodes sized to roughly NodeBytes bytes of elements, eg. 256, 1024 or 4096.
+    template <
+        typename Key,
+        typename Value,
+        std::size_t NodeBytes,
+        typename Compare = std::less< Key >,
+        typename Allocator = std::allocator< std::pair< Key, Value > >,
+        typename Geometry = detail::node_geometry< Key, Value, NodeBytes >
+    > using sized_map_base = map_base< Key, Value, Compare, Allocator, typename Geometry::size_type, Geometry::value >;
+
+    template <
+        typename Key,
+        typename Value,
+        std::size_t NodeBytes,
+        typename Compare = std::less< Key >,
+        typename Allocator = std::allocator< std::pair< Key, Value > >,
+        typename Geometry = detail::node_geometry< Key, Value, NodeBytes >
+    > using sized_map = map< Key, Value, Compare, Allocator, typename Geometry::size_type, Geometry::value >;
 }
\ No newline at end of file
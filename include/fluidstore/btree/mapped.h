@@ -0,0 +1,367 @@
+#pragma once
+
+#include <fluidstore/btree/detail/key_search.h>
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace btree
+{
+    namespace detail
+    {
+        // Image starts with a header page, followed by value node pages and internal node pages, level by level.
+        // Nodes are addressed by byte offsets from the start of the image, so the image can be written to a file
+        // and mapped at any address.
+        struct mapped_header
+        {
+            uint64_t magic;
+            uint32_t version;
+            uint32_t page_size;
+            uint32_t key_size;
+            uint32_t value_size;
+            uint32_t depth;
+            uint32_t reserved;
+            uint64_t size;
+            uint64_t root;
+            uint64_t first;
+            uint64_t last;
+        };
+
+        struct mapped_node
+        {
+            uint32_t size;
+            uint32_t reserved;
+            // Next value node, 0 for the last one and for internal nodes.
+            uint64_t next;
+        };
+
+        template < typename Value > struct mapped_value_size { static constexpr std::size_t value = sizeof(Value); static constexpr std::size_t align = alignof(Value); };
+        template <> struct mapped_value_size< void > { static constexpr std::size_t value = 0; static constexpr std::size_t align = 1; };
+
+        template < typename Key, typename Value > struct mapped_reference { using type = std::pair< const Key&, const Value& >; };
+        template < typename Key > struct mapped_reference< Key, void > { using type = const Key&; };
+
+        template < typename Key, typename Value, std::size_t PageSize > struct mapped_layout
+        {
+            static constexpr uint64_t magic = 0x6565727470616d66ull;
+            static constexpr uint32_t version = 1;
+
+            static constexpr std::size_t align(std::size_t offset, std::size_t alignment) { return (offset + alignment - 1) & ~(alignment - 1); }
+
+            static constexpr std::size_t value_size = mapped_value_size< Value >::value;
+            static constexpr std::size_t value_align = mapped_value_size< Value >::align;
+
+            static constexpr std::size_t keys_offset = sizeof(mapped_node);
+
+            static constexpr std::size_t value_capacity = (PageSize - keys_offset - value_align) / (sizeof(Key) + value_size);
+            static constexpr std::size_t values_offset = align(keys_offset + value_capacity * sizeof(Key), value_align);
+
+            // Internal node has one more child than keys.
+            static constexpr std::size_t internal_capacity = (PageSize - keys_offset - 2 * sizeof(uint64_t)) / (sizeof(Key) + sizeof(uint64_t));
+            static constexpr std::size_t children_offset = align(keys_offset + internal_capacity * sizeof(Key), alignof(uint64_t));
+
+            static_assert(PageSize >= sizeof(mapped_header));
+            static_assert(value_capacity >= 2 && internal_capacity >= 2, "page is too small for the key and value");
+            static_assert(values_offset + value_capacity * value_size <= PageSize);
+            static_assert(children_offset + (internal_capacity + 1) * sizeof(uint64_t) <= PageSize);
+        };
+    }
+
+    // Read-only view of a btree stored in a pointer-free image, eg. a memory-mapped file. Nothing is deserialized,
+    // lookups and iteration read the pages in place. Keys and values have to be trivially copyable. Views opened
+    // over writable memory can update values in place.
+    template < typename Key, typename Value, typename Compare = std::less< Key >, std::size_t PageSize = 4096 > class mapped_container
+    {
+        using layout = detail::mapped_layout< Key, Value, PageSize >;
+
+        static_assert(std::is_trivially_copyable_v< Key >);
+        static_assert(std::is_void_v< Value > || std::is_trivially_copyable_v< Value >);
+
+    public:
+        using key_type = Key;
+        using size_type = std::size_t;
+        using value_type = std::conditional_t< std::is_void_v< Value >, Key, std::pair< Key, Value > >;
+
+        struct iterator
+        {
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = typename mapped_container::value_type;
+            using difference_type = std::ptrdiff_t;
+            using reference = typename detail::mapped_reference< Key, Value >::type;
+            using pointer = void;
+
+            iterator(const mapped_container* container, uint64_t node, uint32_t index)
+                : container_(container)
+                , node_(node)
+                , index_(index)
+            {}
+
+            reference operator *() const
+            {
+                if constexpr (std::is_void_v< Value >)
+                {
+                    return container_->keys(node_)[index_];
+                }
+                else
+                {
+                    return { container_->keys(node_)[index_], container_->values(node_)[index_] };
+                }
+            }
+
+            iterator& operator ++ ()
+            {
+                auto n = container_->node(node_);
+                if (++index_ == n->size && n->next)
+                {
+                    node_ = n->next;
+                    index_ = 0;
+                }
+
+                return *this;
+            }
+
+            iterator operator ++ (int)
+            {
+                iterator it = *this;
+                ++*this;
+                return it;
+            }
+
+            bool operator == (const iterator& other) const { return node_ == other.node_ && index_ == other.index_; }
+            bool operator != (const iterator& other) const { return !(*this == other); }
+
+        private:
+            const mapped_container* container_;
+            uint64_t node_;
+            uint32_t index_;
+        };
+
+        using const_iterator = iterator;
+
+        mapped_container(const void* data, std::size_t size)
+            : data_(static_cast< uint8_t* >(const_cast< void* >(data)))
+            , writable_(false)
+        {
+            validate(size);
+        }
+
+        mapped_container(void* data, std::size_t size)
+            : data_(static_cast< uint8_t* >(data))
+            , writable_(true)
+        {
+            validate(size);
+        }
+
+        size_type size() const { return static_cast< size_type >(header()->size); }
+        bool empty() const { return size() == 0; }
+
+        iterator begin() const { return iterator(this, header()->first, 0); }
+        iterator end() const { return iterator(this, header()->last, header()->last ? node(header()->last)->size : 0); }
+
+        iterator lower_bound(const Key& key) const
+        {
+            if (empty())
+            {
+                return end();
+            }
+
+            auto [leaf, index] = find_index(key);
+            if (index == node(leaf)->size && node(leaf)->next)
+            {
+                return iterator(this, node(leaf)->next, 0);
+            }
+
+            return iterator(this, leaf, index);
+        }
+
+        iterator find(const Key& key) const
+        {
+            if (empty())
+            {
+                return end();
+            }
+
+            auto [leaf, index] = find_index(key);
+            if (index < node(leaf)->size && !Compare()(key, keys(leaf)[index]))
+            {
+                return iterator(this, leaf, index);
+            }
+
+            return end();
+        }
+
+        bool contains(const Key& key) const { return find(key) != end(); }
+
+        // Pointer to the value of key that can be written through, nullptr if key is missing.
+        template < typename V = Value > std::enable_if_t< !std::is_void_v< V >, V* > find_value(const Key& key)
+        {
+            if (!writable_)
+            {
+                throw std::logic_error("image is read-only");
+            }
+
+            if (!empty())
+            {
+                auto [leaf, index] = find_index(key);
+                if (index < node(leaf)->size && !Compare()(key, keys(leaf)[index]))
+                {
+                    return const_cast< V* >(values(leaf)) + index;
+                }
+            }
+
+            return nullptr;
+        }
+
+        // Writes sorted and unique range into a new image. Value nodes are filled completely, internal nodes
+        // evenly, so the image is as small as the page size allows.
+        template < typename It > static std::vector< uint8_t > build(It begin, It end)
+        {
+            std::vector< uint8_t > image(PageSize);
+            std::vector< std::pair< uint64_t, Key > > level;
+
+            uint64_t size = 0;
+            uint64_t prev = 0;
+            while (begin != end)
+            {
+                uint64_t offset = allocate_page(image);
+                auto n = reinterpret_cast< detail::mapped_node* >(&image[offset]);
+                auto nkeys = reinterpret_cast< Key* >(&image[offset + layout::keys_offset]);
+
+                for (; begin != end && n->size < layout::value_capacity; ++begin, ++n->size)
+                {
+                    if constexpr (std::is_void_v< Value >)
+                    {
+                        nkeys[n->size] = *begin;
+                    }
+                    else
+                    {
+                        nkeys[n->size] = (*begin).first;
+                        reinterpret_cast< Value* >(&image[offset + layout::values_offset])[n->size] = (*begin).second;
+                    }
+                }
+
+                size += n->size;
+                if (prev)
+                {
+                    reinterpret_cast< detail::mapped_node* >(&image[prev])->next = offset;
+                }
+
+                level.emplace_back(offset, nkeys[0]);
+                prev = offset;
+            }
+
+            detail::mapped_header header{};
+            header.magic = layout::magic;
+            header.version = layout::version;
+            header.page_size = PageSize;
+            header.key_size = sizeof(Key);
+            header.value_size = layout::value_size;
+            header.size = size;
+            header.first = level.empty() ? 0 : level.front().first;
+            header.last = prev;
+            header.depth = level.empty() ? 0 : 1;
+
+            while (level.size() > 1)
+            {
+                // Spread children evenly, so no node ends up with a single child.
+                std::size_t nodes = (level.size() + layout::internal_capacity) / (layout::internal_capacity + 1);
+                std::vector< std::pair< uint64_t, Key > > parents;
+
+                std::size_t child = 0;
+                for (std::size_t i = 0; i < nodes; ++i)
+                {
+                    std::size_t count = (level.size() - child) / (nodes - i);
+
+                    uint64_t offset = allocate_page(image);
+                    auto n = reinterpret_cast< detail::mapped_node* >(&image[offset]);
+                    auto nkeys = reinterpret_cast< Key* >(&image[offset + layout::keys_offset]);
+                    auto nchildren = reinterpret_cast< uint64_t* >(&image[offset + layout::children_offset]);
+
+                    parents.emplace_back(offset, level[child].second);
+                    for (std::size_t j = 0; j < count; ++j, ++child)
+                    {
+                        nchildren[j] = level[child].first;
+                        if (j > 0)
+                        {
+                            nkeys[j - 1] = level[child].second;
+                        }
+                    }
+
+                    n->size = static_cast< uint32_t >(count - 1);
+                }
+
+                level = std::move(parents);
+                ++header.depth;
+            }
+
+            header.root = level.empty() ? 0 : level.front().first;
+            std::memcpy(image.data(), &header, sizeof(header));
+            return image;
+        }
+
+    private:
+        void validate(std::size_t size) const
+        {
+            if (size < PageSize || size % PageSize)
+            {
+                throw std::runtime_error("invalid image size");
+            }
+
+            auto h = header();
+            if (h->magic != layout::magic || h->version != layout::version || h->page_size != PageSize || h->key_size != sizeof(Key) || h->value_size != layout::value_size)
+            {
+                throw std::runtime_error("invalid image header");
+            }
+
+            if (h->root >= size || h->first >= size || h->last >= size)
+            {
+                throw std::runtime_error("invalid image offsets");
+            }
+        }
+
+        static uint64_t allocate_page(std::vector< uint8_t >& image)
+        {
+            uint64_t offset = image.size();
+            image.resize(image.size() + PageSize);
+            return offset;
+        }
+
+        std::pair< uint64_t, uint32_t > find_index(const Key& key) const
+        {
+            uint64_t offset = header()->root;
+            for (auto depth = header()->depth; --depth;)
+            {
+                auto n = node(offset);
+                auto nkeys = keys(offset);
+                auto index = detail::key_search< Key, Compare >::lower_bound(Compare(), nkeys, n->size, key);
+                if (index < n->size && !Compare()(key, nkeys[index]))
+                {
+                    ++index;
+                }
+
+                offset = children(offset)[index];
+            }
+
+            return { offset, detail::key_search< Key, Compare >::lower_bound(Compare(), keys(offset), node(offset)->size, key) };
+        }
+
+        const detail::mapped_header* header() const { return reinterpret_cast< const detail::mapped_header* >(data_); }
+        const detail::mapped_node* node(uint64_t offset) const { return reinterpret_cast< const detail::mapped_node* >(data_ + offset); }
+        const Key* keys(uint64_t offset) const { return reinterpret_cast< const Key* >(data_ + offset + layout::keys_offset); }
+        const uint64_t* children(uint64_t offset) const { return reinterpret_cast< const uint64_t* >(data_ + offset + layout::children_offset); }
+
+        template < typename V = Value > const V* values(uint64_t offset) const { return reinterpret_cast< const V* >(data_ + offset + layout::values_offset); }
+
+        uint8_t* data_;
+        bool writable_;
+    };
+
+    template < typename Key, typename Compare = std::less< Key >, std::size_t PageSize = 4096 > using mapped_set = mapped_container< Key, void, Compare, PageSize >;
+    template < typename Key, typename Value, typename Compare = std::less< Key >, std::size_t PageSize = 4096 > using mapped_map = mapped_container< Key, Value, Compare, PageSize >;
+}
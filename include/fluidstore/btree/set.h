@@ -105,6 +105,23 @@ namespace btree
 
         set(set< Key, Compare, Allocator, NodeSizeType, N, InternalNodeType, ValueNodeType >&& other) = default;
 
+        set(const set< Key, Compare, Allocator, NodeSizeType, N, InternalNodeType, ValueNodeType >& other)
+            : detail::compressed_base< Allocator >(other.get_allocator())
+            , detail::compressed_base< Compare >(other.key_comp())
+        {
+            BTREE_CHECK(base_type::assign(this->get_allocator(), other));
+        }
+
+        set< Key, Compare, Allocator, NodeSizeType, N, InternalNodeType, ValueNodeType >& operator = (const set< Key, Compare, Allocator, NodeSizeType, N, InternalNodeType, ValueNodeType >& other)
+        {
+            if (this != &other)
+            {
+                BTREE_CHECK(base_type::assign(this->get_allocator(), other));
+            }
+
+            return *this;
+        }
+
         ~set()
         {
             clear();
@@ -130,8 +147,16 @@ namespace btree
             BTREE_CHECK_RETURN(base_type::erase(this->get_allocator(), this->key_comp(), it));
         }
 
-        // TODO
-        //iterator  erase(const_iterator first, const_iterator last);
+        iterator erase(const_iterator first, const_iterator last)
+        {
+            BTREE_CHECK_RETURN(base_type::erase(this->get_allocator(), this->key_comp(), first, last));
+        }
+
+        // Erases keys in [lo, hi), returns number of erased elements.
+        size_type erase_range(const value_type& lo, const value_type& hi)
+        {
+            BTREE_CHECK_RETURN(base_type::erase_range(this->get_allocator(), this->key_comp(), lo, hi));
+        }
 
         iterator find(const value_type& key) { return base_type::find(this->key_comp(), key); }
         const_iterator find(const value_type& key) const { return base_type::find(this->key_comp(), key); }
@@ -161,9 +186,27 @@ namespace btree
             BTREE_CHECK(base_type::insert(this->get_allocator(), this->key_comp(), begin, end));
         }
 
+        // Range has to be sorted and unique, empty container is built bottom-up in a linear time.
+        template < typename It > void insert_sorted(It begin, It end, double fill_factor = 1.0)
+        {
+            BTREE_CHECK(base_type::insert_sorted(this->get_allocator(), this->key_comp(), begin, end, fill_factor));
+        }
+
         iterator lower_bound(const value_type& key) { return base_type::lower_bound(this->key_comp(), key); }
         const_iterator lower_bound(const value_type& key) const { return base_type::lower_bound(this->key_comp(), key); }
 
+        // Batched lookups of sorted keys, one iterator is written to out for each key.
+        template < typename It, typename OutputIt > OutputIt find_many(It begin, It end, OutputIt out) const { return base_type::find_many(this->key_comp(), begin, end, out); }
+        template < typename It, typename OutputIt > OutputIt lower_bound_many(It begin, It end, OutputIt out) const { return base_type::lower_bound_many(this->key_comp(), begin, end, out); }
+
+    #if defined(BTREE_INTERNAL_NODE_COUNT)
+        // Order statistics in O(log n): rank is the number of smaller keys, nth is the inverse.
+        size_type rank(const value_type& key) const { return base_type::rank(this->key_comp(), key); }
+        iterator nth(size_type index) const { return base_type::nth(index); }
+        size_type index(const_iterator it) const { return base_type::index(it); }
+        size_type distance(const_iterator first, const_iterator last) const { return base_type::distance(first, last); }
+    #endif
+
         // TODO
         // void insert(initializer_list<value_type> il);    
                 
@@ -171,4 +214,21 @@ namespace btree
         auto get_allocator() const { return detail::compressed_base< Allocator >::get(); }
         auto key_comp() const { return detail::compressed_base< Compare >::get(); }
     };
+
+    // Set with nodes sized to roughly NodeBytes bytes of elements, eg. 256, 1024 or 4096.
+    template <
+        typename Key,
+        std::size_t NodeBytes,
+        typename Compare = std::less< Key >,
+        typename Allocator = std::allocator< Key >,
+        typename Geometry = detail::node_geometry< Key, void, NodeBytes >
+    > using sized_set_base = set_base< Key, Compare, Allocator, typename Geometry::size_type, Geometry::value >;
+
+    template <
+        typename Key,
+        std::size_t NodeBytes,
+        typename Compare = std::less< Key >,
+        typename Allocator = std::allocator< Key >,
+        typename Geometry = detail::node_geometry< Key, void, NodeBytes >
+    > using sized_set = set< Key, Compare, Allocator, typename Geometry::size_type, Geometry::value >;
 }
\ No newline at end of file
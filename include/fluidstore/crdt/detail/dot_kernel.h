@@ -10,6 +10,7 @@
 #include <fluidstore/crdt/detail/dot_kernel_metadata_btree.h>
 #include <fluidstore/crdt/detail/dot_kernel_metadata_stl.h>
 #include <fluidstore/crdt/detail/dot_kernel_metadata_flat.h>
+#include <fluidstore/crdt/detail/dot_kernel_metadata_interval.h>
 
 #include <fluidstore/crdt/allocator.h>
 #include <fluidstore/memory/buffer_allocator.h>
@@ -106,6 +107,14 @@ namespace crdt
         {
             auto allocator = static_cast<Container*>(this)->get_allocator();
             auto& meta = this->get_metadata();
+            if constexpr (detail::dot_kernel_value_handle_enabled_v< Key >)
+            {
+                for (auto&& value : values_)
+                {
+                    value.second.release_handle(allocator);
+                }
+            }
+
             meta.values_clear(allocator, values_);
             meta.clear(allocator);            
         }
@@ -150,8 +159,8 @@ namespace crdt
         
                     for (const auto& counter : rdots)
                     {
-                        // Create dot -> key link
-                        meta.replica_dots_add(allocator, ldata, counter, rkey);
+                        // Create dot -> value link
+                        meta.replica_dots_add(allocator, ldata, counter, get_dot_index(allocator, lvalue.second));
                     }
                 }
 
@@ -175,11 +184,7 @@ namespace crdt
                     std::deque< counter_type, typename std::allocator_traits< decltype(tmp) >::template rebind_alloc< counter_type > > rdotsvalueless(tmp);
 
                     auto& rdata_visited = (*it).second;
-                    std::set_difference(
-                        rdata.counters.begin(), rdata.counters.end(),
-                        rdata_visited.begin(), rdata_visited.end(),
-                        std::back_inserter(rdotsvalueless)
-                    );
+                    meta.counters_difference(rdata.counters, rdata_visited, std::back_inserter(rdotsvalueless));
 
                     meta.counters_clear(tmp, rdata_visited);
 
@@ -203,16 +208,34 @@ namespace crdt
                 auto counter_it = meta.replica_dots_find(ldata, counter);
                 if (counter_it != ldata.dots.end())
                 {
-                    auto& lkey = counter_it->second;
+                    if constexpr (detail::dot_kernel_value_handle_enabled_v< Key >)
+                    {
+                        // Value is reached through the handle, the key is searched for only when the value is removed
+                        auto& lvalue = dot_kernel_value_type::template get_value< dot_kernel_value_type >(counter_it->second);
+                        meta.value_counters_erase(allocator, lvalue.dots, dot_type{ replica_id, counter });
+
+                        if (lvalue.dots.empty())
+                        {
+                            lvalue.release_handle(allocator);
+
+                            // Support for erase iterator return value
+                            auto it = meta.values_erase(allocator, values_, meta.values_find(values_, lvalue.first));
+                            ctx.register_erase(it);
+                        }
+                    }
+                    else
+                    {
+                        auto& lkey = counter_it->second;
 
-                    auto value_it = meta.values_find(values_, lkey);
-                    meta.value_counters_erase(allocator, value_it->second.dots, dot_type{ replica_id, counter });
+                        auto value_it = meta.values_find(values_, lkey);
+                        meta.value_counters_erase(allocator, value_it->second.dots, dot_type{ replica_id, counter });
 
-                    if (value_it->second.dots.empty())
-                    {
-                        // Support for erase iterator return value
-                        auto it = meta.values_erase(allocator, values_, value_it);
-                        ctx.register_erase(it);
+                        if (value_it->second.dots.empty())
+                        {
+                            // Support for erase iterator return value
+                            auto it = meta.values_erase(allocator, values_, value_it);
+                            ctx.register_erase(it);
+                        }
                     }
 
                     meta.replica_dots_erase(allocator, ldata, counter_it);
@@ -297,6 +320,18 @@ namespace crdt
         const values_type& get_values() const { return values_; }
 
     private:
+        auto get_dot_index(Allocator& allocator, dot_kernel_value_type& value)
+        {
+            if constexpr (detail::dot_kernel_value_handle_enabled_v< Key >)
+            {
+                return value.get_handle(allocator);
+            }
+            else
+            {
+                return value.first;
+            }
+        }
+
         counter_type replica_counters_get(replica_id_type id)
         {
             counter_type counter = counter_type();
@@ -351,22 +386,19 @@ namespace crdt
 
         template < typename AllocatorT, typename Counters, typename Context > void counters_collapse(AllocatorT& allocator, Counters& counters, replica_id_type replica_id, Context& context)
         {
+            // Find the leading block of consecutive counters, keep its last counter and erase the rest at once.
             auto& meta = this->get_metadata();
-            auto next = counters.begin();
-            auto prev = next++;
-            for (; next != counters.end();)
+            auto first = counters.begin();
+            auto prev = first;
+            auto next = prev;
+            for (++next; next != counters.end() && *next == *prev + 1; prev = next++)
             {
-                if (*next == *prev + 1)
-                {
-                    // TODO: we should find a largest block to erase, not erase single element and continue
-                    context.register_erase(dot_type{ replica_id, *prev });
-                    next = meta.counters_erase(allocator, counters, prev);
-                    prev = next++;
-                }
-                else
-                {
-                    break;
-                }
+                context.register_erase(dot_type{ replica_id, *prev });
+            }
+
+            if (prev != first)
+            {
+                meta.counters_erase(allocator, counters, first, prev);
             }
         }
 
@@ -2,6 +2,7 @@
 
 #include <fluidstore/crdt/detail/metadata.h>
 
+#include <type_traits>
 
 namespace crdt
 {
@@ -10,5 +11,17 @@ namespace crdt
         template < typename Key, typename Tag, typename Allocator, typename MetadataTag > struct dot_kernel_metadata;
 
         template < typename Container, typename Metadata, typename MetadataTag > struct dot_kernel_metadata_base;
+
+        // Stable reference to a value, owned by the value and updated when the values container moves it.
+        struct dot_kernel_value_handle
+        {
+            void* value;
+        };
+
+        // Dot -> value index stores keys that are not larger than a pointer, other keys are referenced through
+        // a value handle, so they are not copied and the value is reached without a search.
+        template < typename Key > constexpr bool dot_kernel_value_handle_enabled_v = !(std::is_trivially_copyable_v< Key > && sizeof(Key) <= sizeof(void*));
+
+        template < typename Key > using dot_index_type = std::conditional_t< dot_kernel_value_handle_enabled_v< Key >, dot_kernel_value_handle*, Key >;
     }
-}
\ No newline at end of file
+}
@@ -5,6 +5,7 @@
 
 #include <fluidstore/crdt/detail/dot.h>
 #include <fluidstore/crdt/detail/dot_kernel_metadata.h>
+#include <fluidstore/crdt/detail/small_dots.h>
 
 // #define DOTKERNEL_METADATA_HINT
 
@@ -13,6 +14,7 @@ namespace crdt
     namespace detail
     {
         struct metadata_tag_btree_local {};
+        struct metadata_tag_btree_compact {};
         struct metadata_tag_btree_shared {};
         struct metadata_tag_btree_test {};
 
@@ -40,7 +42,7 @@ namespace crdt
             struct replica_data
             {
                 btree::set_base< counter_type > counters;
-                btree::map_base< counter_type, Key > dots;
+                btree::map_base< counter_type, dot_index_type< Key > > dots;
             };
 
             replica_data& get_replica_data(Allocator& allocator, replica_id_type id)
@@ -81,7 +83,7 @@ namespace crdt
                     assert(get_replica_data(allocator, id).counters.empty());
                 }
 
-                get_replica_data(allocator, id).counters.insert(allocator, counter_compare_type(), counters.begin(), counters.end());                
+                get_replica_data(allocator, id).counters.insert_sorted(allocator, counter_compare_type(), counters.begin(), counters.end());
             }            
 
             auto counters_erase(Allocator& allocator, counters_type& counters, typename counters_type::iterator it)
@@ -89,6 +91,11 @@ namespace crdt
                 return counters.erase(allocator, counter_compare_type(), it);
             }
 
+            auto counters_erase(Allocator& allocator, counters_type& counters, typename counters_type::iterator first, typename counters_type::iterator last)
+            {
+                return counters.erase(allocator, counter_compare_type(), first, last);
+            }
+
             void counters_update(Allocator& allocator, counters_type& counters, typename counters_type::iterator it, counter_type value)
             {
                 // TODO: in-place update, this should not change the tree layout
@@ -103,7 +110,8 @@ namespace crdt
 
             template < typename AllocatorT, typename It > void counters_insert(AllocatorT& allocator, counters_type& counters, It begin, It end)
             {
-                counters.insert(allocator, counter_compare_type(), begin, end);
+                // Counters are always sorted, so this is a linear union of both sequences.
+                counters.insert_sorted(allocator, counter_compare_type(), begin, end);
             }
 
             template < typename AllocatorT > void counters_clear(AllocatorT& allocator, counters_type& counters)
@@ -111,7 +119,12 @@ namespace crdt
                 counters.clear(allocator);
             }
 
-            void replica_dots_add(Allocator& allocator, replica_data& replica, counter_type counter, Key key)
+            template < typename LCounters, typename RCounters, typename OutputIt > OutputIt counters_difference(const LCounters& lcounters, const RCounters& rcounters, OutputIt out)
+            {
+                return std::set_difference(lcounters.begin(), lcounters.end(), rcounters.begin(), rcounters.end(), out);
+            }
+
+            void replica_dots_add(Allocator& allocator, replica_data& replica, counter_type counter, dot_index_type< Key > key)
             {
             #if defined(DOTKERNEL_METADATA_HINT)
                 replica.dots.emplace_hint(allocator, counter_compare_type(), replica.dots.end(), counter, key);
@@ -129,7 +142,7 @@ namespace crdt
                 }
             }
 
-            void replica_dots_erase(Allocator& allocator, replica_data& replica, typename btree::map_base< counter_type, Key >::iterator it)
+            void replica_dots_erase(Allocator& allocator, replica_data& replica, typename btree::map_base< counter_type, dot_index_type< Key > >::iterator it)
             {
                 replica.dots.erase(allocator, counter_compare_type(), it);
             }
@@ -228,6 +241,74 @@ namespace crdt
             Metadata metadata_;
         };
 
+        // Same as metadata_tag_btree_local, but dots of a value are stored inline until there are concurrent writes.
+        template <  typename Key, typename Tag, typename Allocator > struct dot_kernel_metadata
+            < Key, Tag, Allocator, metadata_tag_btree_compact >
+            : dot_kernel_metadata< Key, Tag, Allocator, metadata_tag_btree_local >
+        {
+            using base_type = dot_kernel_metadata< Key, Tag, Allocator, metadata_tag_btree_local >;
+            using metadata_tag_type = metadata_tag_btree_compact;
+
+            using typename base_type::replica_id_type;
+            using typename base_type::counter_type;
+
+            using value_counters_type = small_counters< counter_type, typename base_type::counters_type >;
+            using value_type_dots_type = small_dots< replica_id_type, value_counters_type >;
+
+            using base_type::counters_erase;
+            using base_type::counters_update;
+            using base_type::counters_insert;
+
+            auto counters_erase(Allocator& allocator, value_counters_type& counters, typename value_counters_type::iterator it)
+            {
+                return counters.erase(allocator, it);
+            }
+
+            auto counters_erase(Allocator& allocator, value_counters_type& counters, typename value_counters_type::iterator first, typename value_counters_type::iterator last)
+            {
+                return counters.erase(allocator, first, last);
+            }
+
+            void counters_update(Allocator& allocator, value_counters_type& counters, typename value_counters_type::iterator it, counter_type value)
+            {
+                counters.erase(allocator, it);
+                counters.emplace(allocator, value);
+            }
+
+            template < typename AllocatorT, typename It > void counters_insert(AllocatorT& allocator, value_counters_type& counters, It begin, It end)
+            {
+                counters.insert(allocator, begin, end);
+            }
+
+            auto& value_counters_fetch(Allocator& allocator, value_type_dots_type& ldots, replica_id_type id)
+            {
+                return ldots.emplace(allocator, id).first->second;
+            }
+
+            void value_counters_emplace(Allocator& allocator, value_type_dots_type& ldots, dot< replica_id_type, counter_type > dot)
+            {
+                ldots.emplace(allocator, dot.replica_id).first->second.emplace(allocator, dot.counter);
+            }
+
+            void value_counters_erase(Allocator& allocator, value_type_dots_type& ldots, dot< replica_id_type, counter_type > dot)
+            {
+                auto it = ldots.find(dot.replica_id);
+                if (it != ldots.end())
+                {
+                    it->second.erase(allocator, dot.counter);
+                    if (it->second.empty())
+                    {
+                        it->second.clear(allocator);
+                        ldots.erase(allocator, it);
+                    }
+                }
+            }
+        };
+
+        template < typename Container, typename Metadata > struct dot_kernel_metadata_base< Container, Metadata, metadata_tag_btree_compact >
+            : dot_kernel_metadata_base< Container, Metadata, metadata_tag_btree_local >
+        {};
+
         /*
         template <  typename Key, typename Tag, typename Allocator > struct dot_kernel_metadata
             < Key, Tag, Allocator, metadata_tag_btree_test >
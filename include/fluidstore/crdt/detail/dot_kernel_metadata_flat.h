@@ -46,7 +46,7 @@ namespace crdt
             {
                 using allocator_type = Allocator;
                 using counters_allocator_type = typename std::allocator_traits< Allocator >::template rebind_alloc< counter_type >;
-                using dots_allocator_type = typename std::allocator_traits< Allocator >::template rebind_alloc< std::pair< counter_type, Key > >;
+                using dots_allocator_type = typename std::allocator_traits< Allocator >::template rebind_alloc< std::pair< counter_type, dot_index_type< Key > > >;
 
                 template< typename AllocatorT > replica_data(AllocatorT&& allocator)
                     : counters(allocator)
@@ -54,7 +54,7 @@ namespace crdt
                 {}
 
                 boost::container::flat_set< counter_type, std::less< counter_type >, counters_allocator_type > counters;
-                boost::container::flat_map< counter_type, Key, std::less< counter_type >, dots_allocator_type > dots;
+                boost::container::flat_map< counter_type, dot_index_type< Key >, std::less< counter_type >, dots_allocator_type > dots;
             };
 
             using replica_map_allocator_type = typename std::allocator_traits< Allocator >::template rebind_alloc < std::pair< replica_id_type, replica_data > >;
@@ -107,6 +107,11 @@ namespace crdt
                 return counters.erase(it);
             }
 
+            template < typename Counters > auto counters_erase(Allocator&, Counters& counters, typename counters_type::iterator first, typename counters_type::iterator last)
+            {
+                return counters.erase(first, last);
+            }
+
             template < typename Counters > void counters_update(Allocator&, Counters& counters, typename Counters::iterator it, counter_type value)
             {
                 // TODO: in-place update, this should not change the tree layout
@@ -124,7 +129,12 @@ namespace crdt
                 counters.clear();
             }
 
-            void replica_dots_add(Allocator&, replica_data& replica, counter_type counter, Key key)
+            template < typename LCounters, typename RCounters, typename OutputIt > OutputIt counters_difference(const LCounters& lcounters, const RCounters& rcounters, OutputIt out)
+            {
+                return std::set_difference(lcounters.begin(), lcounters.end(), rcounters.begin(), rcounters.end(), out);
+            }
+
+            void replica_dots_add(Allocator&, replica_data& replica, counter_type counter, dot_index_type< Key > key)
             {
                 replica.dots.emplace_hint(replica.dots.end(), counter, key);
             }
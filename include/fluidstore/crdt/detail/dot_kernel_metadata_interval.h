@@ -0,0 +1,213 @@
+#pragma once
+
+#include <fluidstore/btree/interval_set.h>
+#include <fluidstore/btree/map.h>
+
+#include <fluidstore/crdt/detail/dot.h>
+#include <fluidstore/crdt/detail/dot_kernel_metadata.h>
+
+namespace crdt
+{
+    namespace detail
+    {
+        // Same as metadata_tag_btree_local, but counters are stored as runs of consecutive counters.
+        struct metadata_tag_btree_interval {};
+
+        template <  typename Key, typename Tag, typename Allocator > struct dot_kernel_metadata
+            < Key, Tag, Allocator, metadata_tag_btree_interval >
+        {
+            using metadata_tag_type = metadata_tag_btree_interval;
+
+            using allocator_type = Allocator;
+            using replica_type = typename allocator_type::replica_type;
+            using replica_id_type = typename replica_type::replica_id_type;
+            using counter_type = typename replica_type::counter_type;
+            using compare_type = std::less< Key >;
+
+            using counter_compare_type = std::less< counter_type >;
+            using replica_id_compare_type = std::less< replica_id_type >;
+
+            using counters_type = btree::interval_set_base< counter_type >;
+            using value_type_dots_type = btree::map_base < replica_id_type, counters_type >;
+
+            template < typename KeyT, typename ValueT > using values_map_type = btree::map_base< KeyT, ValueT >;
+            template < typename AllocatorT > using visited_map_type = btree::map< replica_id_type, counters_type, replica_id_compare_type, AllocatorT >;
+
+            // Replicas
+            struct replica_data
+            {
+                counters_type counters;
+                btree::map_base< counter_type, dot_index_type< Key > > dots;
+            };
+
+            replica_data& get_replica_data(Allocator& allocator, replica_id_type id)
+            {
+                return replica_.emplace(allocator, replica_id_compare_type(), id, replica_data()).first->second;
+            }
+
+            replica_data* get_replica_data(replica_id_type id)
+            {
+                auto it = replica_.find(replica_id_compare_type(), id);
+                return it != replica_.end() ? &it->second : nullptr;
+            }
+
+            counter_type replica_counters_get(replica_data& replica)
+            {
+                return !replica.counters.empty() ? *--replica.counters.end() : counter_type();
+            }
+
+            void replica_counters_add(Allocator& allocator, replica_id_type id, counter_type counter)
+            {
+                if (std::is_same_v< Tag, tag_state >)
+                {
+                    assert(get_replica_data(allocator, id).counters.empty());
+                }
+
+                get_replica_data(allocator, id).counters.emplace(allocator, counter);
+            }
+
+            template < typename Counters > void replica_counters_add(Allocator& allocator, replica_id_type id, Counters& counters)
+            {
+                if (std::is_same_v< Tag, tag_state >)
+                {
+                    assert(get_replica_data(allocator, id).counters.empty());
+                }
+
+                get_replica_data(allocator, id).counters.insert_sorted(allocator, counters.begin(), counters.end());
+            }
+
+            auto counters_erase(Allocator& allocator, counters_type& counters, typename counters_type::iterator it)
+            {
+                return counters.erase(allocator, it);
+            }
+
+            auto counters_erase(Allocator& allocator, counters_type& counters, typename counters_type::iterator first, typename counters_type::iterator last)
+            {
+                return counters.erase(allocator, first, last);
+            }
+
+            void counters_update(Allocator& allocator, counters_type& counters, typename counters_type::iterator it, counter_type value)
+            {
+                counters.erase(allocator, it);
+                counters.insert(allocator, value, value);
+            }
+
+            template < typename AllocatorT, typename It > void counters_insert(AllocatorT& allocator, counters_type& counters, It begin, It end)
+            {
+                counters.insert_sorted(allocator, begin, end);
+            }
+
+            template < typename AllocatorT > void counters_clear(AllocatorT& allocator, counters_type& counters)
+            {
+                counters.clear(allocator);
+            }
+
+            template < typename Counters, typename OutputIt > OutputIt counters_difference(const Counters& lcounters, const counters_type& rcounters, OutputIt out)
+            {
+                return lcounters.difference(rcounters, out);
+            }
+
+            void replica_dots_add(Allocator& allocator, replica_data& replica, counter_type counter, dot_index_type< Key > key)
+            {
+                replica.dots.emplace(allocator, counter_compare_type(), counter, key);
+            }
+
+            void replica_dots_erase(Allocator& allocator, replica_id_type id, counter_type counter)
+            {
+                auto replica = get_replica_data(id);
+                if (replica)
+                {
+                    replica->dots.erase(allocator, counter_compare_type(), counter);
+                }
+            }
+
+            void replica_dots_erase(Allocator& allocator, replica_data& replica, typename btree::map_base< counter_type, dot_index_type< Key > >::iterator it)
+            {
+                replica.dots.erase(allocator, counter_compare_type(), it);
+            }
+
+            auto replica_dots_find(replica_data& replica, counter_type counter)
+            {
+                return replica.dots.find(counter_compare_type(), counter);
+            }
+
+            auto& value_counters_fetch(Allocator& allocator, value_type_dots_type& ldots, replica_id_type id)
+            {
+                return ldots.emplace(allocator, replica_id_compare_type(), id, counters_type()).first->second;
+            }
+
+            void value_counters_emplace(Allocator& allocator, value_type_dots_type& ldots, dot< replica_id_type, counter_type > dot)
+            {
+                auto& counters = ldots.emplace(allocator, replica_id_compare_type(), dot.replica_id, counters_type()).first->second;
+                counters.emplace(allocator, dot.counter);
+            }
+
+            void value_counters_erase(Allocator& allocator, value_type_dots_type& ldots, dot< replica_id_type, counter_type > dot)
+            {
+                auto it = ldots.find(replica_id_compare_type(), dot.replica_id);
+                if (it != ldots.end())
+                {
+                    it->second.erase(allocator, dot.counter);
+                    if (it->second.empty())
+                    {
+                        ldots.erase(allocator, replica_id_compare_type(), it);
+                    }
+                }
+            }
+
+            template < typename Values, typename Value > auto values_emplace(Allocator& allocator, Values& values, const Key& key, Value&& value)
+            {
+                return values.emplace(allocator, compare_type(), key, std::forward< Value >(value));
+            }
+
+            template < typename Values > auto values_find(Values& values, const Key& key)
+            {
+                return values.find(compare_type(), key);
+            }
+
+            template < typename Values > auto values_erase(Allocator& allocator, Values& values, typename Values::iterator it)
+            {
+                return values.erase(allocator, compare_type(), it);
+            }
+
+            template < typename Values > void values_clear(Allocator& allocator, Values& values)
+            {
+                for (auto&& value : values)
+                {
+                    for (auto&& [replica_id, dots] : value.second.dots)
+                    {
+                        dots.clear(allocator);
+                    }
+
+                    value.second.dots.clear(allocator);
+                }
+                values.clear(allocator);
+            }
+
+            const btree::map_base < replica_id_type, replica_data >& get_replica_map() const { return replica_; }
+            btree::map_base < replica_id_type, replica_data >& get_replica_map() { return replica_; }
+
+            void clear(Allocator& allocator)
+            {
+                for (auto&& [replica_id, data] : replica_)
+                {
+                    data.counters.clear(allocator);
+                    data.dots.clear(allocator);
+                }
+                replica_.clear(allocator);
+            }
+
+        private:
+            btree::map_base < replica_id_type, replica_data > replica_;
+        };
+
+        template < typename Container, typename Metadata > struct dot_kernel_metadata_base< Container, Metadata, metadata_tag_btree_interval >
+        {
+            Metadata& get_metadata() { return metadata_; }
+            const Metadata& get_metadata() const { return metadata_; }
+
+        private:
+            Metadata metadata_;
+        };
+    }
+}
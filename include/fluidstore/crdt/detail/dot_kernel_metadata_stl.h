@@ -46,7 +46,7 @@ namespace crdt
             {
                 using allocator_type = Allocator;
                 using counters_allocator_type = typename std::allocator_traits< Allocator >::template rebind_alloc< counter_type >;
-                using dots_allocator_type = typename std::allocator_traits< Allocator >::template rebind_alloc< std::pair< const counter_type, Key > >;
+                using dots_allocator_type = typename std::allocator_traits< Allocator >::template rebind_alloc< std::pair< const counter_type, dot_index_type< Key > > >;
 
                 template< typename AllocatorT > replica_data(AllocatorT&& allocator)
                     : counters(allocator)
@@ -54,7 +54,7 @@ namespace crdt
                 {}
 
                 std::set< counter_type, std::less< counter_type >, counters_allocator_type > counters;
-                std::map< counter_type, Key, std::less< counter_type >, dots_allocator_type > dots;
+                std::map< counter_type, dot_index_type< Key >, std::less< counter_type >, dots_allocator_type > dots;
             };
 
             using replica_map_allocator_type = typename std::allocator_traits< Allocator >::template rebind_alloc < std::pair< const replica_id_type, replica_data > >;
@@ -107,6 +107,11 @@ namespace crdt
                 return counters.erase(it);
             }
 
+            template < typename Counters > auto counters_erase(Allocator&, Counters& counters, typename counters_type::iterator first, typename counters_type::iterator last)
+            {
+                return counters.erase(first, last);
+            }
+
             template < typename Counters > void counters_update(Allocator&, Counters& counters, typename Counters::iterator it, counter_type value)
             {
                 // TODO: in-place update, this should not change the tree layout
@@ -124,7 +129,12 @@ namespace crdt
                 counters.clear();
             }
 
-            void replica_dots_add(Allocator&, replica_data& replica, counter_type counter, Key key)
+            template < typename LCounters, typename RCounters, typename OutputIt > OutputIt counters_difference(const LCounters& lcounters, const RCounters& rcounters, OutputIt out)
+            {
+                return std::set_difference(lcounters.begin(), lcounters.end(), rcounters.begin(), rcounters.end(), out);
+            }
+
+            void replica_dots_add(Allocator&, replica_data& replica, counter_type counter, dot_index_type< Key > key)
             {
                 replica.dots.emplace_hint(replica.dots.end(), counter, key);
             }
@@ -138,7 +148,7 @@ namespace crdt
                 }
             }
 
-            void replica_dots_erase(Allocator&, replica_data& replica, typename std::map< counter_type, Key >::iterator it)
+            void replica_dots_erase(Allocator&, replica_data& replica, typename decltype(replica_data::dots)::iterator it)
             {
                 replica.dots.erase(it);
             }
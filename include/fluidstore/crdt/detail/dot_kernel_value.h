@@ -1,9 +1,97 @@
 # pragma once
 
+#include <fluidstore/crdt/detail/dot_kernel_metadata.h>
+
+#include <cassert>
+#include <memory>
+#include <utility>
+
 namespace crdt
 {
+    namespace detail
+    {
+        // Owns the handle of a value referenced by the dot index. The handle points to this subobject and is
+        // retargeted on every move, so it stays valid while the values container reorganizes its nodes.
+        template < bool Enabled > class dot_kernel_value_handle_base
+        {
+        public:
+            dot_kernel_value_handle_base()
+                : handle_()
+            {}
+
+            dot_kernel_value_handle_base(dot_kernel_value_handle_base< Enabled >&& other)
+                : handle_(other.handle_)
+            {
+                other.handle_ = nullptr;
+                retarget();
+            }
+
+            dot_kernel_value_handle_base< Enabled >& operator = (dot_kernel_value_handle_base< Enabled >&& other)
+            {
+                std::swap(handle_, other.handle_);
+                retarget();
+                other.retarget();
+                return *this;
+            }
+
+        #if defined(_DEBUG)
+            ~dot_kernel_value_handle_base()
+            {
+                assert(!handle_);
+            }
+        #endif
+
+            template < typename Allocator > dot_kernel_value_handle* get_handle(Allocator& allocator)
+            {
+                if (!handle_)
+                {
+                    auto alloc = typename std::allocator_traits< Allocator >::template rebind_alloc< dot_kernel_value_handle >(allocator);
+                    handle_ = std::allocator_traits< decltype(alloc) >::allocate(alloc, 1);
+                    retarget();
+                }
+
+                return handle_;
+            }
+
+            template < typename Allocator > void release_handle(Allocator& allocator)
+            {
+                if (handle_)
+                {
+                    auto alloc = typename std::allocator_traits< Allocator >::template rebind_alloc< dot_kernel_value_handle >(allocator);
+                    std::allocator_traits< decltype(alloc) >::deallocate(alloc, handle_, 1);
+                    handle_ = nullptr;
+                }
+            }
+
+            template < typename Value > static Value& get_value(const dot_kernel_value_handle* handle)
+            {
+                return static_cast< Value& >(*static_cast< dot_kernel_value_handle_base< Enabled >* >(handle->value));
+            }
+
+        private:
+            void retarget()
+            {
+                if (handle_)
+                {
+                    handle_->value = this;
+                }
+            }
+
+            dot_kernel_value_handle* handle_;
+        };
+
+        template <> class dot_kernel_value_handle_base< false >
+        {
+        public:
+            template < typename Allocator > void release_handle(Allocator&) {}
+        };
+    }
+
     template < typename Key, typename Value, typename Allocator, typename DotContextCounters, typename DotKernel > class dot_kernel_value
+        : public detail::dot_kernel_value_handle_base< detail::dot_kernel_value_handle_enabled_v< Key > >
     {
+        using handle_base_type = detail::dot_kernel_value_handle_base< detail::dot_kernel_value_handle_enabled_v< Key > >;
+
     public:
         using allocator_type = Allocator;
         using dot_kernel_value_type = dot_kernel_value< Key, Value, Allocator, DotContextCounters, DotKernel >;
@@ -37,7 +125,8 @@ namespace crdt
         {}
 
         dot_kernel_value(dot_kernel_value_type&& other)
-            : first(std::move(other.first))
+            : handle_base_type(std::move(other))
+            , first(std::move(other.first))
             , parent(other.parent)
             , dots(std::move(other.dots))
             , value(std::move(other.value))
@@ -47,6 +136,7 @@ namespace crdt
 
         dot_kernel_value_type& operator = (dot_kernel_value_type&& other)
         {
+            handle_base_type::operator = (std::move(other));
             std::swap(first, other.first);
 
             std::swap(value, other.value);
@@ -81,6 +171,7 @@ namespace crdt
     };
 
     template < typename Key, typename Allocator, typename DotContextCounters, typename DotKernel > class dot_kernel_value< Key, void, Allocator, DotContextCounters, DotKernel >
+        : public detail::dot_kernel_value_handle_base< detail::dot_kernel_value_handle_enabled_v< Key > >
     {
     public:
         using allocator_type = Allocator;
@@ -0,0 +1,412 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace crdt
+{
+    namespace detail
+    {
+        // Counters of a single replica for a single value. Usually there is only one, so it is stored inline, more
+        // counters spill to Counters allocated from the allocator passed to modifying calls.
+        template < typename Counter, typename Counters > class small_counters
+        {
+            using compare_type = std::less< Counter >;
+
+        public:
+            using value_type = Counter;
+            using size_type = std::size_t;
+
+            struct iterator
+            {
+                friend small_counters< Counter, Counters >;
+
+                using iterator_category = std::forward_iterator_tag;
+                using difference_type = std::ptrdiff_t;
+                using value_type = Counter;
+                using pointer = const Counter*;
+                using reference = const Counter&;
+
+                iterator() = default;
+
+                iterator(const Counter* ptr)
+                    : ptr_(ptr)
+                {}
+
+                iterator(typename Counters::iterator it)
+                    : ptr_()
+                    , it_(it)
+                {}
+
+                bool operator == (const iterator& rhs) const { return ptr_ ? ptr_ == rhs.ptr_ : it_ == rhs.it_; }
+                bool operator != (const iterator& rhs) const { return !(*this == rhs); }
+
+                reference operator*() const { return ptr_ ? *ptr_ : *it_; }
+                pointer operator->() const { return &**this; }
+
+                iterator& operator++()
+                {
+                    if (ptr_)
+                    {
+                        ++ptr_;
+                    }
+                    else
+                    {
+                        ++it_;
+                    }
+
+                    return *this;
+                }
+
+                iterator operator++(int)
+                {
+                    iterator it = *this;
+                    ++*this;
+                    return it;
+                }
+
+            private:
+                const Counter* ptr_;
+                typename Counters::iterator it_;
+            };
+
+            using const_iterator = iterator;
+
+            small_counters()
+                : storage_()
+                , size_()
+                , spilled_()
+            {}
+
+            small_counters(small_counters< Counter, Counters >&& other)
+                : storage_(other.storage_)
+                , size_(other.size_)
+                , spilled_(other.spilled_)
+            {
+                other.size_ = 0;
+                other.spilled_ = false;
+            }
+
+            small_counters< Counter, Counters >& operator = (small_counters< Counter, Counters >&& other)
+            {
+                std::swap(storage_, other.storage_);
+                std::swap(size_, other.size_);
+                std::swap(spilled_, other.spilled_);
+                return *this;
+            }
+
+            small_counters(const small_counters< Counter, Counters >&) = delete;
+            small_counters< Counter, Counters >& operator = (const small_counters< Counter, Counters >&) = delete;
+
+        #if defined(_DEBUG)
+            ~small_counters()
+            {
+                assert(!spilled_);
+            }
+        #endif
+
+            iterator begin() const { return spilled_ ? iterator(storage_.counters->begin()) : iterator(&storage_.counter); }
+            iterator end() const { return spilled_ ? iterator(storage_.counters->end()) : iterator(&storage_.counter + size_); }
+
+            size_type size() const { return spilled_ ? storage_.counters->size() : size_; }
+            bool empty() const { return size() == 0; }
+
+            template < typename Allocator > bool emplace(Allocator& allocator, Counter counter)
+            {
+                if (!spilled_)
+                {
+                    if (size_ == 0)
+                    {
+                        storage_.counter = counter;
+                        size_ = 1;
+                        return true;
+                    }
+                    else if (storage_.counter == counter)
+                    {
+                        return false;
+                    }
+
+                    spill(allocator);
+                }
+
+                return storage_.counters->emplace(allocator, compare_type(), counter).second;
+            }
+
+            template < typename Allocator, typename It > void insert(Allocator& allocator, It begin, It end)
+            {
+                while (begin != end)
+                {
+                    emplace(allocator, *begin++);
+                }
+            }
+
+            template < typename Allocator > iterator erase(Allocator& allocator, iterator it)
+            {
+                if (spilled_)
+                {
+                    return storage_.counters->erase(allocator, compare_type(), it.it_);
+                }
+
+                size_ = 0;
+                return end();
+            }
+
+            template < typename Allocator > iterator erase(Allocator& allocator, iterator first, iterator last)
+            {
+                if (spilled_)
+                {
+                    return storage_.counters->erase(allocator, compare_type(), first.it_, last.it_);
+                }
+
+                if (first != last)
+                {
+                    size_ = 0;
+                }
+
+                return end();
+            }
+
+            template < typename Allocator > size_type erase(Allocator& allocator, Counter counter)
+            {
+                if (spilled_)
+                {
+                    return storage_.counters->erase(allocator, compare_type(), counter);
+                }
+
+                if (size_ && storage_.counter == counter)
+                {
+                    size_ = 0;
+                    return 1;
+                }
+
+                return 0;
+            }
+
+            template < typename Allocator > void clear(Allocator& allocator)
+            {
+                if (spilled_)
+                {
+                    auto alloc = typename std::allocator_traits< Allocator >::template rebind_alloc< Counters >(allocator);
+                    storage_.counters->clear(allocator);
+                    std::allocator_traits< decltype(alloc) >::destroy(alloc, storage_.counters);
+                    std::allocator_traits< decltype(alloc) >::deallocate(alloc, storage_.counters, 1);
+                    spilled_ = false;
+                }
+
+                size_ = 0;
+            }
+
+        private:
+            template < typename Allocator > void spill(Allocator& allocator)
+            {
+                auto alloc = typename std::allocator_traits< Allocator >::template rebind_alloc< Counters >(allocator);
+                auto counters = std::allocator_traits< decltype(alloc) >::allocate(alloc, 1);
+                std::allocator_traits< decltype(alloc) >::construct(alloc, counters);
+                if (size_)
+                {
+                    counters->emplace(allocator, compare_type(), storage_.counter);
+                }
+
+                storage_.counters = counters;
+                spilled_ = true;
+            }
+
+            union storage
+            {
+                Counter counter;
+                Counters* counters;
+            };
+
+            storage storage_;
+            uint8_t size_;
+            bool spilled_;
+        };
+
+        // Replica to counters map of a single value. Values almost always have a dot of a single replica, so up to N
+        // entries are stored inline and the map spills to an allocated sorted array only after concurrent writes.
+        template < typename ReplicaId, typename Counters, std::size_t N = 1 > class small_dots
+        {
+        public:
+            using key_type = ReplicaId;
+            using value_type = std::pair< ReplicaId, Counters >;
+            using size_type = uint32_t;
+            using iterator = value_type*;
+            using const_iterator = const value_type*;
+
+            small_dots()
+                : size_()
+                , capacity_(N)
+            {}
+
+            small_dots(small_dots< ReplicaId, Counters, N >&& other)
+                : size_(other.size_)
+                , capacity_(other.capacity_)
+            {
+                if (capacity_ > N)
+                {
+                    data_ = other.data_;
+                }
+                else
+                {
+                    move(other.inline_data(), inline_data(), size_);
+                }
+
+                other.size_ = 0;
+                other.capacity_ = N;
+            }
+
+            small_dots< ReplicaId, Counters, N >& operator = (small_dots< ReplicaId, Counters, N >&& other)
+            {
+                assert(capacity_ == N);
+                destroy(begin(), size_);
+                new (this) small_dots< ReplicaId, Counters, N >(std::move(other));
+                return *this;
+            }
+
+            small_dots(const small_dots< ReplicaId, Counters, N >&) = delete;
+            small_dots< ReplicaId, Counters, N >& operator = (const small_dots< ReplicaId, Counters, N >&) = delete;
+
+            ~small_dots()
+            {
+                assert(capacity_ == N);
+                destroy(begin(), size_);
+            }
+
+            iterator begin() { return data(); }
+            iterator end() { return data() + size_; }
+            const_iterator begin() const { return data(); }
+            const_iterator end() const { return data() + size_; }
+
+            size_type size() const { return size_; }
+            bool empty() const { return size_ == 0; }
+
+            iterator find(const ReplicaId& id)
+            {
+                auto it = lower_bound(id);
+                return it != end() && it->first == id ? it : end();
+            }
+
+            const_iterator find(const ReplicaId& id) const { return const_cast< small_dots< ReplicaId, Counters, N >& >(*this).find(id); }
+
+            template < typename Allocator > std::pair< iterator, bool > emplace(Allocator& allocator, const ReplicaId& id)
+            {
+                auto it = lower_bound(id);
+                if (it != end() && it->first == id)
+                {
+                    return { it, false };
+                }
+
+                size_type index = static_cast< size_type >(it - begin());
+                if (size_ == capacity_)
+                {
+                    grow(allocator);
+                }
+
+                auto p = data();
+                if (index < size_)
+                {
+                    new (p + size_) value_type(std::move(p[size_ - 1]));
+                    for (size_type i = size_ - 1; i > index; --i)
+                    {
+                        p[i] = std::move(p[i - 1]);
+                    }
+
+                    p[index].~value_type();
+                }
+
+                new (p + index) value_type(id, Counters());
+                ++size_;
+                return { p + index, true };
+            }
+
+            template < typename Allocator > iterator erase(Allocator&, iterator it)
+            {
+                auto p = data();
+                for (auto next = it + 1; next != p + size_; ++next)
+                {
+                    *(next - 1) = std::move(*next);
+                }
+
+                p[--size_].~value_type();
+                return it;
+            }
+
+            // Releases storage of the map, counters have to be cleared already.
+            template < typename Allocator > void clear(Allocator& allocator)
+            {
+                destroy(begin(), size_);
+                if (capacity_ > N)
+                {
+                    auto alloc = typename std::allocator_traits< Allocator >::template rebind_alloc< value_type >(allocator);
+                    std::allocator_traits< decltype(alloc) >::deallocate(alloc, data_, capacity_);
+                    capacity_ = N;
+                }
+
+                size_ = 0;
+            }
+
+        private:
+            iterator lower_bound(const ReplicaId& id)
+            {
+                auto it = begin();
+                while (it != end() && it->first < id)
+                {
+                    ++it;
+                }
+
+                return it;
+            }
+
+            template < typename Allocator > void grow(Allocator& allocator)
+            {
+                auto alloc = typename std::allocator_traits< Allocator >::template rebind_alloc< value_type >(allocator);
+                size_type capacity = capacity_ * 2;
+                auto p = std::allocator_traits< decltype(alloc) >::allocate(alloc, capacity);
+                move(data(), p, size_);
+                if (capacity_ > N)
+                {
+                    std::allocator_traits< decltype(alloc) >::deallocate(alloc, data_, capacity_);
+                }
+
+                data_ = p;
+                capacity_ = capacity;
+            }
+
+            static void move(value_type* source, value_type* target, size_type size)
+            {
+                for (size_type i = 0; i < size; ++i)
+                {
+                    new (target + i) value_type(std::move(source[i]));
+                    source[i].~value_type();
+                }
+            }
+
+            static void destroy(value_type* p, size_type size)
+            {
+                for (size_type i = 0; i < size; ++i)
+                {
+                    p[i].~value_type();
+                }
+            }
+
+            value_type* inline_data() { return reinterpret_cast< value_type* >(&inline_); }
+            value_type* data() { return capacity_ > N ? data_ : inline_data(); }
+            const value_type* data() const { return const_cast< small_dots< ReplicaId, Counters, N >& >(*this).data(); }
+
+            union
+            {
+                std::aligned_storage_t< sizeof(value_type) * N, alignof(value_type) > inline_;
+                value_type* data_;
+            };
+
+            size_type size_;
+            size_type capacity_;
+        };
+    }
+}
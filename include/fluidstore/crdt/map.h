@@ -3,6 +3,7 @@
 #include <fluidstore/crdt/detail/dot_kernel.h>
 #include <fluidstore/crdt/set.h>
 
+#include <optional>
 #include <stdexcept>
 
 namespace crdt
@@ -109,6 +110,30 @@ namespace crdt
                 return { context.result.first, context.result.second };
             }
 
+            // Inserts key and value pairs using consecutive dots of a single delta, so the range is merged and committed once.
+            template < typename It > void insert(It first, It last)
+            {
+                if (first != last)
+                {
+                    auto allocator = this->get_allocator();
+                    memory::static_buffer< temporary_buffer_size > buffer;
+                    memory::buffer_allocator< void, decltype(buffer), std::allocator< void > > buffer_allocator(buffer);
+                    crdt::allocator< typename decltype(allocator)::replica_type, void, decltype(buffer_allocator) > tmp(allocator.get_replica(), buffer_allocator);
+
+                    typename delta_type::template rebind_t< decltype(tmp) > delta(tmp);
+
+                    auto dot = this->get_next_dot();
+                    for (; first != last; ++first, ++dot.counter)
+                    {
+                        delta.add_counter_dot(dot);
+                        delta.add_value((*first).first, dot, (*first).second);
+                    }
+
+                    merge(delta);
+                    this->commit_delta(delta);
+                }
+            }
+
             auto& operator[](const Key& key)
             {
                 if constexpr (std::uses_allocator_v< Value, Allocator >)
@@ -180,6 +205,36 @@ namespace crdt
                 return 0;
             }
 
+            iterator erase(iterator first, iterator last)
+            {
+                if (first == last)
+                {
+                    return last;
+                }
+
+                // Values are not erased in key order, so the result is looked up again
+                std::optional< Key > next;
+                if (last != end())
+                {
+                    next.emplace((*last).first);
+                }
+
+                auto allocator = this->get_allocator();
+                memory::static_buffer< temporary_buffer_size > buffer;
+                memory::buffer_allocator< void, decltype(buffer), std::allocator< void > > buffer_allocator(buffer);
+                crdt::allocator< typename decltype(allocator)::replica_type, void, decltype(buffer_allocator) > tmp(allocator.get_replica(), buffer_allocator);
+
+                typename delta_type::template rebind_t< decltype(tmp) > delta(tmp);
+                for (; first != last; ++first)
+                {
+                    delta.add_counter_dots(first.it_->second.dots);
+                }
+
+                merge(delta);
+                this->commit_delta(std::move(delta));
+                return next ? find(*next) : end();
+            }
+
             using dot_kernel_type::size;
             using dot_kernel_type::find;
             using dot_kernel_type::empty;
@@ -5,6 +5,8 @@
 
 #include <fluidstore/crdt/hooks/hook_default.h>
 
+#include <optional>
+
 namespace crdt
 {
     namespace detail
@@ -100,6 +102,25 @@ namespace crdt
                 return { context.result.first, context.result.second };
             }
 
+            // Inserts keys using consecutive dots of a single delta, so the range is merged and committed once.
+            template < typename It > void insert(It first, It last)
+            {
+                if (first != last)
+                {
+                    auto allocator = this->get_allocator();
+
+                    memory::static_buffer< temporary_buffer_size > buffer;
+                    memory::buffer_allocator< void, decltype(buffer), std::allocator< void > > buffer_allocator(buffer);
+                    crdt::allocator< typename decltype(allocator)::replica_type, void, decltype(buffer_allocator) > deltaallocator(allocator.get_replica(), buffer_allocator);
+
+                    typename delta_type::template rebind_t< decltype(deltaallocator) > delta(deltaallocator);
+                    delta_insert(delta, first, last);
+
+                    merge(delta);
+                    this->commit_delta(std::move(delta));
+                }
+            }
+
             iterator erase(iterator it)
             {
                 typename dot_kernel_type::erase_context context;
@@ -107,6 +128,37 @@ namespace crdt
                 return context.iterator;
             }
 
+            iterator erase(iterator first, iterator last)
+            {
+                if (first == last)
+                {
+                    return last;
+                }
+
+                // Values are not erased in key order, so the result is looked up again
+                std::optional< Key > next;
+                if (last != end())
+                {
+                    next.emplace(*last);
+                }
+
+                auto allocator = this->get_allocator();
+
+                memory::static_buffer< temporary_buffer_size > buffer;
+                memory::buffer_allocator< void, decltype(buffer), std::allocator< void > > buffer_allocator(buffer);
+                crdt::allocator< typename decltype(allocator)::replica_type, void, decltype(buffer_allocator) > deltaallocator(allocator.get_replica(), buffer_allocator);
+
+                typename delta_type::template rebind_t< decltype(deltaallocator) > delta(deltaallocator);
+                for (; first != last; ++first)
+                {
+                    delta.add_counter_dots(first.it_->second.dots);
+                }
+
+                merge(delta);
+                this->commit_delta(std::move(delta));
+                return next ? find(*next) : end();
+            }
+
             size_t erase(const Key& key)
             {
                 auto it = find(key);
@@ -163,6 +215,16 @@ namespace crdt
                 delta.add_value(key, dot);
             }
 
+            template < typename Delta, typename It > void delta_insert(Delta& delta, It first, It last)
+            {
+                auto dot = this->get_next_dot();
+                for (; first != last; ++first, ++dot.counter)
+                {
+                    delta.add_counter_dot(dot);
+                    delta.add_value(*first, dot);
+                }
+            }
+
             void erase(iterator it, typename dot_kernel_type::erase_context& context)
             {
                 auto allocator = this->get_allocator();
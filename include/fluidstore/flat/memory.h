@@ -28,7 +28,7 @@ namespace crdt::flat
         }
         else
         {
-        #if defined(__clang__)
+        #if defined(__clang__) || defined(__GNUC__)
             std::abort();
         #else
             static_assert(false);
@@ -102,7 +102,7 @@ namespace crdt::flat
         }
         else
         {
-        #if defined(__clang__)
+        #if defined(__clang__) || defined(__GNUC__)
             std::abort();
         #else
             static_assert(false);
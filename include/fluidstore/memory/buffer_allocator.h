@@ -2,7 +2,10 @@
 
 // Allocator is based on https://howardhinnant.github.io/allocator_boilerplate.html
 
+#include <algorithm>
 #include <array>
+#include <cstddef>
+#include <cstdint>
 #include <new>
 #include <memory>
 
@@ -231,6 +234,202 @@ namespace memory
         std::size_t allocated_;
     };
 
+    // Pool of fixed-size objects carved from slabs, intended for btree nodes. Single object allocations are kept
+    // in intrusive free lists per object size; other requests are declined so buffer_allocator uses its fallback.
+    // Slabs start small and double up to SlabSize, so small trees stay small. Slabs are returned only on release()
+    // or destruction.
+    template<
+        std::size_t SlabSize = 64 * 1024,
+        std::size_t Classes = 4,
+        typename Allocator = std::allocator< std::max_align_t >
+    > class pool_buffer
+        : private compressed_base< Allocator >
+    {
+        pool_buffer(const pool_buffer&) = delete;
+        pool_buffer& operator = (const pool_buffer&) = delete;
+
+        pool_buffer(pool_buffer&&) = delete;
+        pool_buffer& operator = (pool_buffer&&) = delete;
+
+        struct free_node
+        {
+            free_node* next;
+        };
+
+        struct slab_header
+        {
+            slab_header* next;
+            std::size_t blocks;
+        };
+
+        static constexpr std::size_t alignment = alignof(std::max_align_t);
+        static constexpr std::size_t header_blocks = (sizeof(slab_header) + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t);
+        static constexpr std::size_t max_blocks = SlabSize / sizeof(std::max_align_t);
+        static constexpr std::size_t min_blocks = std::max< std::size_t >(max_blocks / 64, header_blocks + 1);
+
+        static_assert(max_blocks > header_blocks);
+
+        struct size_class
+        {
+            std::size_t size;
+            free_node* free;
+        };
+
+    public:
+        pool_buffer()
+            : classes_()
+            , slabs_()
+            , current_()
+            , end_()
+            , allocated_()
+            , reserved_()
+        {}
+
+        template< typename AllocatorT > pool_buffer(AllocatorT&& allocator)
+            : compressed_base< Allocator >(std::forward< AllocatorT >(allocator))
+            , classes_()
+            , slabs_()
+            , current_()
+            , end_()
+            , allocated_()
+            , reserved_()
+        {}
+
+        ~pool_buffer()
+        {
+            release();
+        }
+
+        template < typename T > T* allocate(std::size_t n)
+        {
+            auto cls = n == 1 ? get_class< T >(true) : nullptr;
+            if (!cls)
+            {
+                return nullptr;
+            }
+
+            uint8_t* ptr;
+            if (cls->free)
+            {
+                ptr = reinterpret_cast< uint8_t* >(cls->free);
+                cls->free = cls->free->next;
+            }
+            else
+            {
+                if (static_cast< std::size_t >(end_ - current_) < cls->size)
+                {
+                    allocate_slab(cls->size);
+                }
+
+                ptr = current_;
+                current_ += cls->size;
+            }
+
+            allocated_ += sizeof(T);
+            return reinterpret_cast< T* >(ptr);
+        }
+
+        template < typename T > bool deallocate(T* p, std::size_t n)
+        {
+            // Classes are never reassigned, so an object of a pooled size was allocated from the pool.
+            auto cls = n == 1 ? get_class< T >(false) : nullptr;
+            if (!cls)
+            {
+                return false;
+            }
+
+            auto node = reinterpret_cast< free_node* >(p);
+            node->next = cls->free;
+            cls->free = node;
+
+            allocated_ -= sizeof(T);
+            return true;
+        }
+
+        // Returns all slabs at once. Objects allocated from the pool must not be used afterwards.
+        void release()
+        {
+            while (slabs_)
+            {
+                auto next = slabs_->next;
+                this->get_allocator().deallocate(reinterpret_cast< std::max_align_t* >(slabs_), slabs_->blocks);
+                slabs_ = next;
+            }
+
+            for (auto& cls : classes_)
+            {
+                cls.free = nullptr;
+            }
+
+            current_ = end_ = nullptr;
+            allocated_ = reserved_ = 0;
+        }
+
+        std::size_t get_allocated() const { return allocated_; }
+        std::size_t get_reserved() const { return reserved_; }
+
+        auto get_allocator() { return compressed_base< Allocator >::get(); }
+
+    private:
+        template < typename T > size_class* get_class(bool create)
+        {
+            if constexpr (alignof(T) > alignment || sizeof(T) > (max_blocks - header_blocks) * sizeof(std::max_align_t))
+            {
+                return nullptr;
+            }
+            else
+            {
+                constexpr std::size_t size = (std::max(sizeof(T), sizeof(free_node)) + alignment - 1) & ~(alignment - 1);
+                for (auto& cls : classes_)
+                {
+                    if (cls.size == size)
+                    {
+                        return &cls;
+                    }
+                    else if (cls.size == 0)
+                    {
+                        if (!create)
+                        {
+                            return nullptr;
+                        }
+
+                        cls.size = size;
+                        return &cls;
+                    }
+                }
+
+                return nullptr;
+            }
+        }
+
+        void allocate_slab(std::size_t size)
+        {
+            auto blocks = slabs_ ? std::min(slabs_->blocks * 2, max_blocks) : min_blocks;
+            while ((blocks - header_blocks) * sizeof(std::max_align_t) < size)
+            {
+                blocks = std::min(blocks * 2, max_blocks);
+            }
+
+            // Slabs are linked through a header in their first blocks.
+            auto slab = reinterpret_cast< uint8_t* >(this->get_allocator().allocate(blocks));
+            auto header = reinterpret_cast< slab_header* >(slab);
+            header->next = slabs_;
+            header->blocks = blocks;
+            slabs_ = header;
+
+            current_ = slab + header_blocks * sizeof(std::max_align_t);
+            end_ = slab + blocks * sizeof(std::max_align_t);
+            reserved_ += blocks * sizeof(std::max_align_t);
+        }
+
+        std::array< size_class, Classes > classes_;
+        slab_header* slabs_;
+        uint8_t* current_;
+        uint8_t* end_;
+        std::size_t allocated_;
+        std::size_t reserved_;
+    };
+
     template < typename T > class buffer_allocator_throw
     {
     public:
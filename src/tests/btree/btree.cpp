@@ -1,4 +1,7 @@
+#include <fluidstore/btree/concurrent.h>
+#include <fluidstore/btree/interval_set.h>
 #include <fluidstore/btree/map.h>
+#include <fluidstore/btree/mapped.h>
 #include <fluidstore/btree/set.h>
 #include <fluidstore/flat/set.h>
 #include <fluidstore/memory/buffer_allocator.h>
@@ -8,6 +11,8 @@
 #include <boost/container/flat_set.hpp>
 #include <boost/container/flat_map.hpp>
 #include <iomanip>
+#include <atomic>
+#include <thread>
 
 #include "bench.h"
 #include "shuffle.h"
@@ -523,6 +528,763 @@ BOOST_AUTO_TEST_CASE(btree_lower_bound_pair)
     BOOST_TEST((counters.lower_bound({ 1, 2 }) == counters.end()));
 }
 
+typedef boost::mpl::list < int32_t, uint32_t, int64_t, uint64_t, std::string > btree_key_search_types;
+BOOST_AUTO_TEST_CASE_TEMPLATE(btree_key_search, T, btree_key_search_types)
+{
+    std::vector< T > keys;
+    if constexpr (std::is_integral_v< T >)
+    {
+        keys.push_back(std::numeric_limits< T >::min());
+        // Enough keys to cover the binary search of wide nodes
+        for (int i = 0; i < 150; ++i)
+        {
+            keys.push_back(static_cast< T >(i * 2 - 15));
+        }
+        keys.push_back(std::numeric_limits< T >::max() - 1);
+        keys.push_back(std::numeric_limits< T >::max());
+    }
+    else
+    {
+        for (int i = 0; i < 150; ++i)
+        {
+            keys.push_back(value< T >(i * 2));
+        }
+    }
+
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    using key_search = btree::detail::key_search< T, std::less< T > >;
+    for (size_t size = 0; size <= keys.size(); ++size)
+    {
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            std::vector< T > needles = { keys[i] };
+            if constexpr (std::is_integral_v< T >)
+            {
+                needles.push_back(static_cast< T >(keys[i] + 1));
+                needles.push_back(static_cast< T >(keys[i] - 1));
+            }
+
+            for (auto& needle : needles)
+            {
+                auto expected = std::lower_bound(keys.begin(), keys.begin() + size, needle) - keys.begin();
+                BOOST_REQUIRE(key_search::lower_bound(std::less< T >(), keys.data(), size, needle) == expected);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(btree_set_insert_sorted)
+{
+    for (double fill_factor : { 0.5, 0.75, 1.0 })
+    {
+        for (int count : { 0, 1, 2, 15, 16, 17, 32, 33, 100, 257, 1000, 5000 })
+        {
+            std::vector< int > data;
+            for (int i = 0; i < count; ++i)
+            {
+                data.push_back(i * 2);
+            }
+
+            btree::set< int > c;
+            c.insert_sorted(data.begin(), data.end(), fill_factor);
+            BOOST_REQUIRE(c.size() == data.size());
+            BOOST_REQUIRE(std::equal(c.begin(), c.end(), data.begin(), data.end()));
+
+            for (auto& v : data)
+            {
+                BOOST_REQUIRE((c.find(v) != c.end()));
+                BOOST_REQUIRE((c.lower_bound(v - 1) == c.find(v)));
+            }
+
+            // The tree has to stay usable after bulk load
+            for (int i = 0; i < count; ++i)
+            {
+                BOOST_REQUIRE(c.insert(i * 2 + 1).second);
+            }
+
+            for (int i = 0; i < count; ++i)
+            {
+                BOOST_REQUIRE(c.erase(i * 2) == 1);
+            }
+
+            BOOST_REQUIRE(c.size() == data.size());
+            int i = 0;
+            for (auto& v : c)
+            {
+                BOOST_REQUIRE(v == i++ * 2 + 1);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(btree_map_insert_range)
+{
+    std::vector< std::pair< int, int > > sorted;
+    for (int i = 0; i < 1000; ++i)
+    {
+        sorted.push_back({ i, i + 1 });
+    }
+
+    btree::map< int, int > c;
+    c.insert(sorted.begin(), sorted.end());
+    BOOST_TEST(c.size() == sorted.size());
+    for (auto& [k, v] : sorted)
+    {
+        BOOST_REQUIRE((*c.find(k)).second == v);
+    }
+
+    // Unsorted input or non-empty container takes regular insertion path
+    std::vector< std::pair< int, int > > unsorted(sorted.rbegin(), sorted.rend());
+    btree::map< int, int > c2;
+    c2.insert(unsorted.begin(), unsorted.end());
+    c2.insert(sorted.begin(), sorted.end());
+    BOOST_TEST(c2.size() == sorted.size());
+    for (auto& [k, v] : sorted)
+    {
+        BOOST_REQUIRE((*c2.find(k)).second == v);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(btree_set_insert_sorted_union)
+{
+    for (int lcount : { 1, 17, 100, 1000, 5000 })
+    {
+        for (int rcount : { 1, 10, 100, 1000, 5000 })
+        {
+            // Left side has even numbers, right side every third number, so they partially overlap
+            std::set< int > expected;
+            btree::set< int > c;
+            for (int i = 0; i < lcount; ++i)
+            {
+                c.insert(i * 2);
+                expected.insert(i * 2);
+            }
+
+            std::vector< int > data;
+            for (int i = 0; i < rcount; ++i)
+            {
+                data.push_back(i * 3);
+                expected.insert(i * 3);
+            }
+
+            c.insert_sorted(data.begin(), data.end());
+            BOOST_REQUIRE(c.size() == expected.size());
+            BOOST_REQUIRE(std::equal(c.begin(), c.end(), expected.begin(), expected.end()));
+
+            // Inserting the same range again does not change anything
+            c.insert_sorted(data.begin(), data.end());
+            BOOST_REQUIRE(c.size() == expected.size());
+
+            for (auto& v : expected)
+            {
+                BOOST_REQUIRE(c.erase(v) == 1);
+            }
+            BOOST_REQUIRE(c.empty());
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(btree_map_insert_sorted_union)
+{
+    btree::map< int, int > c;
+    for (int i = 0; i < 1000; ++i)
+    {
+        c.insert({ i * 2, 0 });
+    }
+
+    std::vector< std::pair< int, int > > data;
+    for (int i = 0; i < 1000; ++i)
+    {
+        data.push_back({ i, 1 });
+    }
+
+    c.insert_sorted(data.begin(), data.end());
+    BOOST_TEST(c.size() == 1500);
+    for (int i = 0; i < 2000; ++i)
+    {
+        auto it = c.find(i);
+        if (i < 1000 || i % 2 == 0)
+        {
+            // Existing elements are kept
+            BOOST_REQUIRE((it != c.end()));
+            BOOST_REQUIRE((*it).second == (i % 2 == 0 ? 0 : 1));
+        }
+        else
+        {
+            BOOST_REQUIRE((it == c.end()));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(btree_sized_set, T, test_types)
+{
+    static_assert(std::is_same_v< btree::detail::node_geometry< uint64_t, void, 64 >::size_type, uint8_t >);
+    static_assert(btree::detail::node_geometry< uint64_t, void, 4096 >::value == 256);
+    static_assert(std::is_same_v< btree::detail::node_geometry< uint64_t, void, 4096 >::size_type, uint16_t >);
+    static_assert(btree::detail::node_geometry< uint32_t, uint32_t, 1024 >::value == 64);
+
+    auto test = [](auto& c)
+    {
+        for (size_t i = 0; i < 10000; ++i)
+        {
+            BOOST_REQUIRE(c.insert(value< T >(i * 7919 % 10000)).second);
+        }
+        BOOST_REQUIRE(c.size() == 10000);
+
+        for (size_t i = 0; i < 10000; ++i)
+        {
+            BOOST_REQUIRE((c.find(value< T >(i)) != c.end()));
+        }
+
+        for (size_t i = 0; i < 10000; ++i)
+        {
+            BOOST_REQUIRE(c.erase(value< T >(i * 7919 % 10000)) == 1);
+        }
+        BOOST_REQUIRE(c.empty());
+    };
+
+    if constexpr (!std::is_same_v< T, uint8_t > && !std::is_same_v< T, uint16_t >)
+    {
+        btree::sized_set< T, 256 > c256;
+        test(c256);
+        btree::sized_set< T, 1024 > c1024;
+        test(c1024);
+        btree::sized_set< T, 4096 > c4096;
+        test(c4096);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(btree_sized_map)
+{
+    btree::sized_map< uint64_t, uint64_t, 4096 > c;
+    for (uint64_t i = 0; i < 10000; ++i)
+    {
+        BOOST_REQUIRE(c.insert({ i * 7919 % 10000, i }).second);
+    }
+
+    for (uint64_t i = 0; i < 10000; ++i)
+    {
+        BOOST_REQUIRE((*c.find(i * 7919 % 10000)).second == i);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(btree_set_append)
+{
+    for (int count : { 100, 1000, 10000, 50000 })
+    {
+        std::vector< int > data;
+        for (int i = 0; i < count; ++i)
+        {
+            data.push_back(i);
+        }
+
+        memory::stats_buffer<> bulk_buffer;
+        memory::buffer_allocator< int, decltype(bulk_buffer) > bulk_allocator(bulk_buffer);
+        btree::set< int, std::less< int >, decltype(bulk_allocator) > bulk(bulk_allocator);
+        bulk.insert_sorted(data.begin(), data.end());
+
+        memory::stats_buffer<> append_buffer;
+        memory::buffer_allocator< int, decltype(append_buffer) > append_allocator(append_buffer);
+        btree::set< int, std::less< int >, decltype(append_allocator) > append(append_allocator);
+        for (auto& v : data)
+        {
+            BOOST_REQUIRE(append.insert(v).second);
+        }
+
+        // Appends should produce nearly full nodes, close to the bulk loaded tree
+        BOOST_REQUIRE(append_buffer.get_allocated() <= bulk_buffer.get_allocated() * 11 / 10);
+
+        // Erase from both ends and the middle to go through the rebalancing of sparse right edge
+        for (int i = 0; i < count / 4; ++i)
+        {
+            BOOST_REQUIRE(append.erase(count - 1 - i) == 1);
+            BOOST_REQUIRE(append.erase(i) == 1);
+        }
+
+        for (int i = count / 4; i < count - count / 4; ++i)
+        {
+            BOOST_REQUIRE(append.erase(i) == 1);
+        }
+
+        BOOST_REQUIRE(append.empty());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(btree_set_rank_nth)
+{
+    auto check = [](auto& c)
+    {
+        BOOST_REQUIRE(c.index(c.end()) == c.size());
+        BOOST_REQUIRE((c.nth(c.size()) == c.end()));
+
+        size_t index = 0;
+        for (auto it = c.begin(); it != c.end(); ++it, ++index)
+        {
+            BOOST_REQUIRE(c.index(it) == index);
+            BOOST_REQUIRE(c.rank(*it) == index);
+            BOOST_REQUIRE(c.rank(*it + 1) == index + 1);
+            BOOST_REQUIRE((c.nth(index) == it));
+        }
+
+        BOOST_REQUIRE(c.distance(c.begin(), c.end()) == c.size());
+    };
+
+    for (int count : { 1, 100, 1000, 10000 })
+    {
+        std::vector< int > data;
+        for (int i = 0; i < count; ++i)
+        {
+            data.push_back(i * 2);
+        }
+
+        btree::set< int > bulk;
+        bulk.insert_sorted(data.begin(), data.end());
+        check(bulk);
+
+        btree::set< int > append;
+        for (auto& v : data)
+        {
+            append.insert(v);
+        }
+        check(append);
+
+        shuffle(data);
+        btree::set< int > random;
+        for (auto& v : data)
+        {
+            random.insert(v);
+        }
+        check(random);
+
+        std::vector< int > odd;
+        for (int i = 0; i < count; ++i)
+        {
+            odd.push_back(i * 2 + 1);
+        }
+        random.insert_sorted(odd.begin(), odd.end());
+        check(random);
+
+        for (int i = 0; i < count; ++i)
+        {
+            random.erase(data[i]);
+            if (i % 97 == 0)
+            {
+                check(random);
+            }
+        }
+        check(random);
+        BOOST_REQUIRE(random.size() == static_cast< size_t >(count));
+    }
+
+    btree::map< int, int > map;
+    for (int i = 0; i < 1000; ++i)
+    {
+        map.insert({ i * 7919 % 1000, i });
+    }
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        BOOST_REQUIRE(map.rank(i) == static_cast< size_t >(i));
+        BOOST_REQUIRE((*map.nth(i)).first == i);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(btree_set_find_many)
+{
+    for (int count : { 0, 1, 100, 10000 })
+    {
+        btree::set< int > c;
+        for (int i = 0; i < count; ++i)
+        {
+            c.insert(i * 3);
+        }
+
+        std::vector< int > keys;
+        for (int i = -2; i < count * 3 + 2; i += 2)
+        {
+            keys.push_back(i);
+        }
+
+        std::vector< btree::set< int >::iterator > found;
+        c.find_many(keys.begin(), keys.end(), std::back_inserter(found));
+        BOOST_REQUIRE(found.size() == keys.size());
+
+        std::vector< btree::set< int >::iterator > bounds;
+        c.lower_bound_many(keys.begin(), keys.end(), std::back_inserter(bounds));
+        BOOST_REQUIRE(bounds.size() == keys.size());
+
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            BOOST_REQUIRE((found[i] == c.find(keys[i])));
+            BOOST_REQUIRE((bounds[i] == c.lower_bound(keys[i])));
+        }
+    }
+
+    btree::map< int, int > map;
+    for (int i = 0; i < 1000; ++i)
+    {
+        map.insert({ i, i * 2 });
+    }
+
+    std::vector< int > keys = { 1, 10, 500, 999, 1000 };
+    std::vector< btree::map< int, int >::iterator > found;
+    map.find_many(keys.begin(), keys.end(), std::back_inserter(found));
+    for (size_t i = 0; i < 4; ++i)
+    {
+        BOOST_REQUIRE((*found[i]).second == keys[i] * 2);
+    }
+    BOOST_REQUIRE((found[4] == map.end()));
+}
+
+BOOST_AUTO_TEST_CASE(btree_set_erase_range)
+{
+    for (int count : { 1, 100, 1000, 10000 })
+    {
+        for (auto [lo, hi] : std::vector< std::pair< int, int > >{ { 0, 0 }, { 0, 1 }, { 0, count }, { 10, count / 3 }, { count / 4, count - count / 4 }, { count / 3, 2 * count / 3 }, { count / 3, count + 5 }, { count / 10, count } })
+        {
+            btree::set< int > c;
+            std::set< int > expected;
+            for (int i = 0; i < count; ++i)
+            {
+                c.insert(i);
+                expected.insert(i);
+            }
+
+            auto erased = c.erase_range(lo, hi);
+            hi = std::max(lo, hi);
+            BOOST_REQUIRE(erased == static_cast< size_t >(std::distance(expected.lower_bound(lo), expected.lower_bound(hi))));
+            expected.erase(expected.lower_bound(lo), expected.lower_bound(hi));
+
+            BOOST_REQUIRE(c.size() == expected.size());
+            BOOST_REQUIRE(std::equal(c.begin(), c.end(), expected.begin(), expected.end()));
+
+            // The tree stays usable
+            for (int i = 0; i < count; ++i)
+            {
+                c.insert(i);
+            }
+            BOOST_REQUIRE(c.size() == static_cast< size_t >(count));
+
+            auto it = c.erase(c.find(count / 2), c.end());
+            BOOST_REQUIRE((it == c.end()));
+            BOOST_REQUIRE(c.size() == static_cast< size_t >(count / 2));
+        }
+    }
+
+    btree::map< int, int > map;
+    for (int i = 0; i < 1000; ++i)
+    {
+        map.insert({ i, i });
+    }
+
+    auto it = map.erase(map.find(100), map.find(200));
+    BOOST_REQUIRE((*it).first == 200);
+    BOOST_REQUIRE(map.size() == 900);
+    BOOST_REQUIRE(map.erase_range(0, 1000) == 900);
+    BOOST_REQUIRE(map.empty());
+}
+
+BOOST_AUTO_TEST_CASE(btree_set_pool)
+{
+    memory::pool_buffer<> pool;
+    memory::buffer_allocator< int, decltype(pool), std::allocator< int > > allocator(pool);
+
+    {
+        btree::set< int, std::less< int >, decltype(allocator) > c(allocator);
+        for (int i = 0; i < 10000; ++i)
+        {
+            c.insert(i * 7919 % 10000);
+        }
+
+        auto reserved = pool.get_reserved();
+        BOOST_REQUIRE(pool.get_allocated() > 0);
+        BOOST_REQUIRE(reserved >= pool.get_allocated());
+
+        for (int i = 0; i < 10000; i += 2)
+        {
+            BOOST_REQUIRE(c.erase(i) == 1);
+        }
+
+        // Freed nodes are reused
+        for (int i = 0; i < 10000; i += 2)
+        {
+            BOOST_REQUIRE(c.insert(i).second);
+        }
+        BOOST_REQUIRE(pool.get_reserved() == reserved);
+
+        c.clear();
+        BOOST_REQUIRE(pool.get_allocated() == 0);
+    }
+
+    pool.release();
+    BOOST_REQUIRE(pool.get_reserved() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(btree_set_snapshot)
+{
+    for (int count : { 0, 1, 100, 10000 })
+    {
+        btree::set< int > c;
+        for (int i = 0; i < count; ++i)
+        {
+            c.insert(i * 7919 % count);
+        }
+
+        auto snapshot = std::make_shared< const btree::set< int > >(c);
+        BOOST_REQUIRE(snapshot->size() == c.size());
+        BOOST_REQUIRE(std::equal(c.begin(), c.end(), snapshot->begin(), snapshot->end()));
+
+        // Snapshot does not see later changes
+        for (int i = 0; i < count; i += 2)
+        {
+            c.erase(i);
+        }
+        c.insert(count);
+
+        BOOST_REQUIRE(snapshot->size() == static_cast< size_t >(count));
+        for (int i = 0; i < count; ++i)
+        {
+            BOOST_REQUIRE((snapshot->find(i) != snapshot->end()));
+        }
+        BOOST_REQUIRE((snapshot->find(count) == snapshot->end()));
+
+        btree::set< int > copy;
+        copy.insert(-1);
+        copy = c;
+        BOOST_REQUIRE(std::equal(c.begin(), c.end(), copy.begin(), copy.end()));
+    }
+
+    btree::map< int, std::string > map;
+    for (int i = 0; i < 1000; ++i)
+    {
+        map.insert({ i, std::to_string(i) });
+    }
+
+    btree::map< int, std::string > copy(map);
+    map.erase(1);
+    BOOST_REQUIRE(copy.size() == 1000);
+    BOOST_REQUIRE((*copy.find(1)).second == "1");
+}
+
+BOOST_AUTO_TEST_CASE(btree_concurrent)
+{
+    const int Threads = 4;
+    const int Count = 10000;
+
+    btree::concurrent_set< int > set;
+    btree::concurrent_map< int, int > map;
+    btree::concurrent_map< int, int > counters;
+
+    // Boost.Test assertions are not thread-safe, failures are counted and checked after join.
+    std::atomic< int > failures(0);
+
+    std::vector< std::thread > threads;
+    for (int t = 0; t < Threads; ++t)
+    {
+        threads.emplace_back([&, t]
+        {
+            for (int i = t; i < Count; i += Threads)
+            {
+                failures += !set.insert(i);
+                failures += !map.insert({ i, i * 2 });
+                failures += !set.contains(i);
+                counters.update(i % 10, [](int& value) { ++value; });
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    BOOST_REQUIRE(failures == 0);
+    BOOST_REQUIRE(set.size() == Count);
+    BOOST_REQUIRE(map.size() == Count);
+    BOOST_REQUIRE(*map.find(11) == 22);
+    BOOST_REQUIRE(!map.find(Count));
+
+    int next = 0;
+    set.for_each([&](int value) { BOOST_REQUIRE(value == next++); });
+    BOOST_REQUIRE(next == Count);
+
+    for (int i = 0; i < 10; ++i)
+    {
+        BOOST_REQUIRE(*counters.find(i) == Count / 10);
+    }
+
+    for (int i = 0; i < Count; i += 2)
+    {
+        BOOST_REQUIRE(set.erase(i) == 1);
+    }
+    BOOST_REQUIRE(set.size() == Count / 2);
+    set.clear();
+    BOOST_REQUIRE(set.empty());
+}
+
+BOOST_AUTO_TEST_CASE(btree_mapped)
+{
+    {
+        std::vector< int > empty;
+        auto image = btree::mapped_set< int >::build(empty.begin(), empty.end());
+        btree::mapped_set< int > set(static_cast< const void* >(image.data()), image.size());
+        BOOST_REQUIRE(set.empty());
+        BOOST_REQUIRE(set.begin() == set.end());
+        BOOST_REQUIRE(set.find(1) == set.end());
+    }
+
+    for (int size : { 1, 10, 1000, 100000 })
+    {
+        btree::set< int > s;
+        btree::map< int, int > m;
+        for (int i = 0; i < size; ++i)
+        {
+            s.insert(i * 2);
+            m.insert({ i * 2, i });
+        }
+
+        {
+            auto image = btree::mapped_set< int >::build(s.begin(), s.end());
+            btree::mapped_set< int > set(static_cast< const void* >(image.data()), image.size());
+            BOOST_REQUIRE(set.size() == s.size());
+            BOOST_REQUIRE(std::equal(set.begin(), set.end(), s.begin(), s.end()));
+
+            for (int i = -1; i < size * 2 + 1; ++i)
+            {
+                BOOST_REQUIRE(set.contains(i) == (s.find(i) != s.end()));
+                auto it = set.lower_bound(i);
+                auto sit = s.lower_bound(i);
+                BOOST_REQUIRE((it == set.end()) == (sit == s.end()));
+                if (sit != s.end())
+                {
+                    BOOST_REQUIRE(*it == *sit);
+                }
+            }
+        }
+
+        {
+            auto image = btree::mapped_map< int, int >::build(m.begin(), m.end());
+            btree::mapped_map< int, int > map(image.data(), image.size());
+            BOOST_REQUIRE(map.size() == m.size());
+            for (int i = 0; i < size; ++i)
+            {
+                auto it = map.find(i * 2);
+                BOOST_REQUIRE((*it).first == i * 2);
+                BOOST_REQUIRE((*it).second == i);
+
+                *map.find_value(i * 2) = -i;
+                BOOST_REQUIRE((*map.find(i * 2)).second == -i);
+            }
+            BOOST_REQUIRE(map.find_value(1) == nullptr);
+        }
+    }
+
+    {
+        std::vector< int > one{ 1 };
+        auto image = btree::mapped_set< int >::build(one.begin(), one.end());
+        BOOST_REQUIRE_THROW(btree::mapped_set< long long >(static_cast< const void* >(image.data()), image.size()), std::runtime_error);
+        BOOST_REQUIRE_THROW(btree::mapped_set< int >(static_cast< const void* >(image.data()), image.size() - 1), std::runtime_error);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(btree_interval_set)
+{
+    std::allocator< int > allocator;
+    btree::interval_set_base< int > set;
+    std::set< int > reference;
+
+    auto check = [&]
+    {
+        BOOST_REQUIRE(set.size() == reference.size());
+        BOOST_REQUIRE(std::equal(set.begin(), set.end(), reference.begin(), reference.end()));
+        BOOST_REQUIRE(std::equal(std::make_reverse_iterator(set.end()), std::make_reverse_iterator(set.begin()), reference.rbegin(), reference.rend()));
+    };
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        BOOST_REQUIRE(set.emplace(allocator, i).second);
+    }
+    BOOST_REQUIRE(!set.emplace(allocator, 10).second);
+    BOOST_REQUIRE(set.runs() == 1);
+    BOOST_REQUIRE(set.size() == 1000);
+
+    srand(1);
+    for (int i = 0; i < 1000; ++i)
+    {
+        reference.insert(i);
+    }
+
+    for (int i = 0; i < 2000; ++i)
+    {
+        int lo = rand() % 2000;
+        switch (rand() % 4)
+        {
+        case 0:
+        {
+            int hi = lo + rand() % 20;
+            BOOST_REQUIRE(set.insert(allocator, lo, hi) == [&] { size_t added = 0; for (int v = lo; v <= hi; ++v) added += reference.insert(v).second; return added; }());
+            break;
+        }
+        case 1:
+            BOOST_REQUIRE(set.erase(allocator, lo) == reference.erase(lo));
+            break;
+        case 2:
+        {
+            auto first = set.find(lo);
+            if (first != set.end())
+            {
+                auto last = first;
+                for (int n = rand() % 30; n && last != set.end(); --n)
+                {
+                    ++last;
+                }
+
+                auto rfirst = reference.find(lo);
+                auto rlast = last != set.end() ? reference.find(*last) : reference.end();
+                auto it = set.erase(allocator, first, last);
+                auto rit = reference.erase(rfirst, rlast);
+                BOOST_REQUIRE((it == set.end()) == (rit == reference.end()));
+                BOOST_REQUIRE((it == set.end() || *it == *rit));
+            }
+            break;
+        }
+        case 3:
+        {
+            auto it = set.find(lo);
+            BOOST_REQUIRE((it != set.end()) == (reference.find(lo) != reference.end()));
+            break;
+        }
+        }
+
+        check();
+    }
+
+    btree::interval_set_base< int > other;
+    std::set< int > rother;
+    for (int i = 0; i < 500; ++i)
+    {
+        int value = rand() % 2000;
+        other.emplace(allocator, value);
+        rother.insert(value);
+    }
+
+    std::vector< int > difference;
+    set.difference(other, std::back_inserter(difference));
+    std::vector< int > rdifference;
+    std::set_difference(reference.begin(), reference.end(), rother.begin(), rother.end(), std::back_inserter(rdifference));
+    BOOST_REQUIRE(difference == rdifference);
+
+    set.insert_sorted(allocator, other.begin(), other.end());
+    reference.insert(rother.begin(), rother.end());
+    check();
+
+    set.clear(allocator);
+    other.clear(allocator);
+    BOOST_REQUIRE(set.empty());
+}
+
 BOOST_AUTO_TEST_CASE(btree_set_random)
 {
     std::vector< int > data;
@@ -1054,6 +1816,79 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(btree_map_set_find, T, btree_perf_insert_types)
     }
 }
 
+typedef boost::mpl::list < uint32_t, uint64_t, std::string > btree_perf_geometry_types;
+BOOST_AUTO_TEST_CASE_TEMPLATE(btree_set_perf_geometry, T, btree_perf_geometry_types)
+{
+    set_realtime_priority();
+
+    auto data = get_vector_data< T >(Max);
+
+    std::map< int, double > base;
+    for (size_t i = 1; i < Max; i *= 2)
+    {
+        base[i] = measure([&]
+        {
+            std::set< T > c;
+            insertion_test(c, data, i);
+            find_test(c, data, i);
+        });
+    }
+
+    auto sweep = [&](auto c, const char* name)
+    {
+        std::cout << "btree::set " << get_type_name<T>() << " " << name << " node insertion and find" << std::endl;
+        std::map< int, double > results;
+        for (size_t i = 1; i < Max; i *= 2)
+        {
+            results[i] = measure([&]
+            {
+                decltype(c) c;
+                insertion_test(c, data, i);
+                find_test(c, data, i);
+            });
+        }
+        print_results(results, base);
+    };
+
+    sweep(btree::set< T >(), "default");
+    sweep(btree::sized_set< T, 256 >(), "256B");
+    sweep(btree::sized_set< T, 1024 >(), "1KiB");
+    sweep(btree::sized_set< T, 4096 >(), "4KiB");
+}
+
+BOOST_AUTO_TEST_CASE(btree_set_perf_pool)
+{
+    set_realtime_priority();
+
+    auto data = get_vector_data< uint64_t >(Max);
+
+    std::map< int, double > base;
+    for (size_t i = 1; i < Max; i *= 2)
+    {
+        base[i] = measure([&]
+        {
+            btree::set< uint64_t > c;
+            insertion_test(c, data, i);
+            find_test(c, data, i);
+        });
+    }
+
+    std::cout << "btree::set uint64_t pool insertion and find" << std::endl;
+    std::map< int, double > results;
+    for (size_t i = 1; i < Max; i *= 2)
+    {
+        results[i] = measure([&]
+        {
+            memory::pool_buffer<> pool;
+            memory::buffer_allocator< uint64_t, decltype(pool), std::allocator< uint64_t > > allocator(pool);
+            btree::set< uint64_t, std::less< uint64_t >, decltype(allocator) > c(allocator);
+            insertion_test(c, data, i);
+            find_test(c, data, i);
+        });
+    }
+    print_results(results, base);
+}
+
 BOOST_AUTO_TEST_CASE(btree_memory_overhead)
 {
     const int Max = 32768*4;
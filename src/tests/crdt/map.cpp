@@ -115,6 +115,37 @@ BOOST_AUTO_TEST_CASE(map_value_mv_merge)
     BOOST_TEST(map2.size() == 0);
 }
 
+BOOST_AUTO_TEST_CASE(map_batch_operations)
+{
+    crdt::map< int, crdt::value_mv< int >, decltype(allocator), crdt::tag_state, crdt::detail::metadata_tag_btree_local, crdt::hook_extract > map1(allocator);
+    crdt::map< int, crdt::value_mv< int >, decltype(allocator), crdt::tag_state, crdt::detail::metadata_tag_btree_local, crdt::hook_extract > map2(allocator);
+
+    auto value1 = crdt::value_mv< int, decltype(allocator), crdt::tag_state, crdt::detail::metadata_tag_btree_local >(allocator);
+    value1.set(1);
+
+    std::vector< std::pair< int, const decltype(value1)& > > values;
+    for (int i = 0; i < 100; ++i)
+    {
+        values.emplace_back(i, value1);
+    }
+
+    map1.insert(values.begin(), values.end());
+    BOOST_TEST(map1.size() == 100);
+    BOOST_TEST((map1.at(99) == 1));
+
+    map2.merge(map1.extract_delta());
+    BOOST_TEST(map2.size() == 100);
+    BOOST_TEST((map2.at(0) == 1));
+
+    BOOST_TEST((map1.erase(map1.find(10), map1.find(90)) == map1.find(90)));
+    BOOST_TEST(map1.size() == 20);
+
+    map2.merge(map1.extract_delta());
+    BOOST_TEST(map2.size() == 20);
+    BOOST_TEST((map2.find(50) == map2.end()));
+    BOOST_TEST((map2.at(90) == 1));
+}
+
 BOOST_AUTO_TEST_CASE(map_map_value_mv_merge)
 {
     crdt::replica<> replica0(0);
@@ -129,6 +129,26 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(crdt_set_insert, T, crdt_set_insert_types)
         print_results(results, base);
     }
 
+    {
+        std::cout << "crdt::set<" << get_type_name<T>() << ", btree, default, batch>" << " insertion " << std::endl;
+        std::map< int, double > results;
+        for (size_t i = 1; i < Max; i *= 2)
+        {
+            memory::dynamic_buffer< std::allocator< uint8_t > > buffer(preallocated);
+            memory::buffer_allocator< T, decltype(buffer) > alloc(buffer);
+
+            results[i] = measure(Iters, [&, alloc]
+                {
+                    crdt::replica<> replica(0);
+                    crdt::allocator< crdt::replica<>, T, decltype(alloc) > allocator(replica, alloc);
+                    crdt::set< T, decltype(allocator), crdt::tag_state, crdt::detail::metadata_tag_btree_local, crdt::hook_default > c(allocator);
+
+                    c.insert(data.begin(), data.begin() + i);
+                });
+        }
+        print_results(results, base);
+    }
+
     {
         std::cout << "crdt::set<" << get_type_name<T>() << ", stl, default>" << " insertion " << std::endl;
         std::map< int, double > results;
@@ -491,6 +511,29 @@ BOOST_AUTO_TEST_CASE(crdt_set_memory_overhead)
         print_results(results, base);
     }
 
+    {
+        std::map< size_t, double > results;
+        for (int i = 1; i < Max; i *= 2)
+        {
+            memory::stats_buffer<> buffer;
+            memory::buffer_allocator< int, decltype(buffer) > bufferallocator(buffer);
+
+            crdt::replica<> replica(0);
+            crdt::allocator< crdt::replica<>, int, decltype(bufferallocator) > allocator(replica, bufferallocator);
+
+            crdt::set< int, decltype(allocator), crdt::tag_state, crdt::detail::metadata_tag_btree_compact, crdt::hook_default > s(allocator);
+            for (int j = 0; j < i; ++j)
+            {
+                s.insert(j);
+            }
+
+            results[i] = buffer.get_allocated();
+        }
+
+        std::cout << "crdt::set [btree compact] memory usage compared to std::set" << std::endl;
+        print_results(results, base);
+    }
+
     {
         std::map< size_t, double > results;
         for (int i = 1; i < Max; i *= 2)
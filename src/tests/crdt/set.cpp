@@ -115,6 +115,201 @@ BOOST_AUTO_TEST_CASE(set_merge)
     BOOST_TEST((set1.find(11) != set1.end()));
 }
 
+BOOST_AUTO_TEST_CASE(set_interval_metadata)
+{
+    crdt::set< int, decltype(allocator), crdt::tag_state, crdt::detail::metadata_tag_btree_interval, crdt::hook_extract > set1(allocator);
+    crdt::set< int, decltype(allocator), crdt::tag_state, crdt::detail::metadata_tag_btree_interval, crdt::hook_extract > set2(allocator);
+    crdt::set< int, decltype(allocator), crdt::tag_state, crdt::detail::metadata_tag_btree_local, crdt::hook_extract > set3(allocator);
+    crdt::set< int, decltype(allocator), crdt::tag_state, crdt::detail::metadata_tag_btree_local, crdt::hook_extract > set4(allocator);
+
+    auto check = [&]
+    {
+        std::vector< int > values2, values4;
+        for (auto& value : set2)
+        {
+            values2.push_back(value);
+        }
+
+        for (auto& value : set4)
+        {
+            values4.push_back(value);
+        }
+
+        BOOST_TEST(values2 == values4);
+
+        auto& counters2 = set2.get_replica_map().begin()->second.counters;
+        auto& counters4 = set4.get_replica_map().begin()->second.counters;
+        BOOST_TEST(std::equal(counters2.begin(), counters2.end(), counters4.begin(), counters4.end()));
+        BOOST_TEST(counters2.runs() <= counters2.size());
+    };
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        set1.insert(i);
+        set3.insert(i);
+    }
+
+    set2.merge(set1.extract_delta());
+    set4.merge(set3.extract_delta());
+    BOOST_TEST(set2.size() == 1000);
+    check();
+
+    for (int i = 0; i < 1000; i += 2)
+    {
+        set1.erase(i);
+        set3.erase(i);
+    }
+
+    set2.merge(set1.extract_delta());
+    set4.merge(set3.extract_delta());
+    BOOST_TEST(set2.size() == 500);
+    BOOST_TEST((set2.find(0) == set2.end()));
+    BOOST_TEST((set2.find(1) != set2.end()));
+    check();
+
+    set2.clear();
+    set1.merge(set2.extract_delta());
+    BOOST_TEST(set1.empty());
+}
+
+template < typename MetadataTag > std::vector< int > set_concurrent_operations(size_t& dots)
+{
+    crdt::replica<> replica0(0);
+    crdt::allocator<> allocator0(replica0);
+    crdt::replica<> replica1(1);
+    crdt::allocator<> allocator1(replica1);
+
+    crdt::set< int, decltype(allocator0), crdt::tag_state, MetadataTag, crdt::hook_extract > set1(allocator0);
+    crdt::set< int, decltype(allocator1), crdt::tag_state, MetadataTag, crdt::hook_extract > set2(allocator1);
+
+    for (int i = 0; i < 100; ++i)
+    {
+        set1.insert(i);
+    }
+
+    for (int i = 0; i < 100; i += 2)
+    {
+        set2.insert(i);
+    }
+
+    set2.merge(set1.extract_delta());
+    set1.merge(set2.extract_delta());
+    BOOST_TEST(set1.size() == 100);
+    BOOST_TEST(set2.size() == 100);
+    dots = set2.get_values().find(std::less< int >(), 0)->second.dots.size();
+
+    set1.insert(1);
+    set2.merge(set1.extract_delta());
+    BOOST_TEST(set2.size() == 100);
+
+    for (int i = 0; i < 100; i += 3)
+    {
+        set1.erase(i);
+    }
+
+    set2.merge(set1.extract_delta());
+
+    std::vector< int > values;
+    for (auto& value : set2)
+    {
+        values.push_back(value);
+    }
+
+    return values;
+}
+
+BOOST_AUTO_TEST_CASE(set_compact_metadata)
+{
+    // Values with dots of two replicas spill from the inline storage, the result has to be the same
+    size_t dots = 0;
+    auto values = set_concurrent_operations< crdt::detail::metadata_tag_btree_local >(dots);
+    BOOST_TEST(dots == 2);
+
+    dots = 0;
+    BOOST_TEST(set_concurrent_operations< crdt::detail::metadata_tag_btree_compact >(dots) == values);
+    BOOST_TEST(dots == 2);
+}
+
+BOOST_AUTO_TEST_CASE(set_batch_operations)
+{
+    crdt::set< int, decltype(allocator), crdt::tag_state, crdt::detail::metadata_tag_btree_local, crdt::hook_extract > set1(allocator);
+    crdt::set< int, decltype(allocator), crdt::tag_state, crdt::detail::metadata_tag_btree_local, crdt::hook_extract > set2(allocator);
+
+    std::vector< int > keys;
+    for (int i = 0; i < 1000; ++i)
+    {
+        keys.push_back(i);
+    }
+
+    set1.insert(keys.begin(), keys.begin());
+    BOOST_TEST(set1.empty());
+
+    // Whole range takes consecutive dots
+    set1.insert(keys.begin(), keys.end());
+    BOOST_TEST(set1.size() == 1000);
+    auto& counters = set1.get_replica_map().begin()->second.counters;
+    BOOST_TEST(counters.size() == 1);
+    BOOST_TEST(*counters.begin() == 1000);
+
+    set2.merge(set1.extract_delta());
+    BOOST_TEST(set2.size() == 1000);
+
+    auto first = set1.find(100);
+    auto last = set1.find(900);
+    BOOST_TEST((set1.erase(first, last) == set1.find(900)));
+    BOOST_TEST(set1.size() == 200);
+    BOOST_TEST((set1.erase(set1.find(900), set1.end()) == set1.end()));
+    BOOST_TEST(set1.size() == 100);
+
+    set2.merge(set1.extract_delta());
+    BOOST_TEST(set2.size() == 100);
+    BOOST_TEST((set2.find(99) != set2.end()));
+    BOOST_TEST((set2.find(100) == set2.end()));
+
+    // Single inserts continue after the batch dots
+    set1.insert(keys.begin() + 500, keys.begin() + 510);
+    set1.insert(1000);
+    set2.merge(set1.extract_delta());
+    BOOST_TEST(set2.size() == 111);
+    BOOST_TEST(*set2.get_replica_map().begin()->second.counters.begin() == 1011);
+}
+
+BOOST_AUTO_TEST_CASE(set_value_handle)
+{
+    static_assert(std::is_same_v< crdt::detail::dot_index_type< int >, int >);
+    static_assert(std::is_same_v< crdt::detail::dot_index_type< std::string >, crdt::detail::dot_kernel_value_handle* >);
+
+    crdt::set< std::string, decltype(allocator), crdt::tag_state, crdt::detail::metadata_tag_btree_local, crdt::hook_extract > set1(allocator);
+    crdt::set< std::string, decltype(allocator), crdt::tag_state, crdt::detail::metadata_tag_btree_local, crdt::hook_extract > set2(allocator);
+
+    // Keys are long enough to be allocated, handles have to follow values moved by node splits and merges
+    auto key = [](int i) { return "value with a long key " + std::to_string(i); };
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        set1.insert(key(i));
+    }
+
+    set2.merge(set1.extract_delta());
+    BOOST_TEST(set2.size() == 1000);
+
+    for (int i = 0; i < 1000; i += 3)
+    {
+        set1.erase(key(i));
+    }
+
+    set2.merge(set1.extract_delta());
+    BOOST_TEST(set2.size() == 666);
+    for (int i = 0; i < 1000; ++i)
+    {
+        BOOST_TEST((set2.find(key(i)) == set2.end()) == (i % 3 == 0));
+    }
+
+    set2.clear();
+    set1.merge(set2.extract_delta());
+    BOOST_TEST(set1.empty());
+}
+
 #define PRINT_SIZEOF(...) std::cerr << "sizeof " << # __VA_ARGS__ << ": " << sizeof(__VA_ARGS__) << std::endl
 
 BOOST_AUTO_TEST_CASE(set_sizeof)
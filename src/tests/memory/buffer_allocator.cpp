@@ -69,3 +69,56 @@ BOOST_AUTO_TEST_CASE(static_dynamic_buffer)
 	allocator.deallocate(heap_p, 1);
 	BOOST_TEST(heap.get_allocated() == 0);
 }
+
+BOOST_AUTO_TEST_CASE(pool_buffer_reuse)
+{
+	memory::pool_buffer< 1024, 2 > pool;
+	memory::buffer_allocator< uint64_t, decltype(pool), std::allocator< uint64_t > > allocator(pool);
+
+	auto p1 = allocator.allocate(1);
+	auto p2 = allocator.allocate(1);
+	BOOST_TEST(pool.get_allocated() == 2 * sizeof(uint64_t));
+	BOOST_TEST(pool.get_reserved() > 0);
+	BOOST_TEST(pool.get_reserved() <= 1024);
+
+	// Freed objects are reused
+	allocator.deallocate(p1, 1);
+	BOOST_TEST(allocator.allocate(1) == p1);
+
+	// Arrays are not pooled
+	auto array = allocator.allocate(4);
+	BOOST_TEST(pool.get_allocated() == 2 * sizeof(uint64_t));
+	allocator.deallocate(array, 4);
+
+	// Other sizes get their own free list until classes run out
+	using big = std::array< uint8_t, 100 >;
+	memory::buffer_allocator< big, decltype(pool), std::allocator< big > > big_allocator(pool);
+	auto b1 = big_allocator.allocate(1);
+	BOOST_TEST(pool.get_allocated() == 2 * sizeof(uint64_t) + sizeof(big));
+
+	using huge = std::array< uint8_t, 2000 >;
+	memory::buffer_allocator< huge, decltype(pool), std::allocator< huge > > huge_allocator(pool);
+	auto h1 = huge_allocator.allocate(1);
+	BOOST_TEST(pool.get_allocated() == 2 * sizeof(uint64_t) + sizeof(big));
+	huge_allocator.deallocate(h1, 1);
+
+	// New slab when the current one is exhausted
+	std::vector< big* > bigs;
+	for (size_t i = 0; i < 20; ++i)
+	{
+		bigs.push_back(big_allocator.allocate(1));
+	}
+	BOOST_TEST(pool.get_reserved() > 20 * sizeof(big));
+
+	for (auto p : bigs)
+	{
+		big_allocator.deallocate(p, 1);
+	}
+	big_allocator.deallocate(b1, 1);
+	allocator.deallocate(p1, 1);
+	allocator.deallocate(p2, 1);
+	BOOST_TEST(pool.get_allocated() == 0);
+
+	pool.release();
+	BOOST_TEST(pool.get_reserved() == 0);
+}